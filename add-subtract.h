@@ -138,6 +138,9 @@ case OP_CMP_ABS:
 case OP_CMP_ZP:
     cmp(readByte(getZPAddr()));
     break;
+case OP_CMP_ZP_IND:
+    cmp(readByte(getZP_INDAddr()));
+    break;
 case OP_CMP_ABS_X:
     cmp(readByte(getABS_XAddr()));
     break;
@@ -1,4 +1,12 @@
 #include "simulieren-6502.h"
+#include "disassembler.h"
+#include "breakpoints.h"
+#include "memory-map.h"
+#include "console.h"
+#include "w65c22.h"
+#include "host-input.h"
+#include "throttle.h"
+#include "wakeup.h"
 #include <cctype>
 #include <cstdlib>
 #include <cstdio>
@@ -9,38 +17,248 @@
 
 extern uint8_t A, X, Y, stackPointer;
 extern uint16_t programCounter;
+extern uint64_t cycleCount;
+extern bool hitSTP;
 extern bool flagNegative, flagOverflow, flagBRK, flagDecimal, flagIRQdisable, flagZero, flagCarry;
 
 #define BUF_SIZE 1024
 
 #define MEMORY_SIZE 0x10000
-#define OUTPUT_ADDR 0x7FFF
+// The console's registers. Guest output is written to OUTPUT_ADDR, as before.
+#define CONSOLE_BASE 0x7FFD
+#define OUTPUT_ADDR (CONSOLE_BASE + CONSOLE_DATA_OUT)
+// The VIA's 16 registers, just below the console.
+#define VIA_BASE 0x7FE0
 
 uint8_t memory[MEMORY_SIZE];
+MemoryMap systemMap;
+Console console;
+W65C22 via;
+HostInput hostInput;
 
-uint16_t breakpoint = 0000;
+// How many instructions free-running executes between looking at host input.
+#define FREE_RUN_BATCH 0x10000
+
+// The emulated clock frequency free-running is paced to, in Hz. 0 runs as fast
+//  as possible.
+uint32_t clockFrequency = 0;
+Throttle throttle;
+
+// Free-running sleeps on this while the processor is idle in WAI or STP.
+Wakeup wakeup;
+
+// when set, every instruction is disassembled as it is executed
+bool tracing = false;
 
 void printRegs() {
     printf("]A = $%02X\tX = $%02X\tY = $%02X\n", A, X, Y);
     printf("]PC = $%04X\tSP = $%02X\n", programCounter, stackPointer);
+    printf("]Cycles = %llu\n", (unsigned long long)cycleCount);
     printf("]Status register: %c%c-%c%c%c%c%c\n",    flagNegative?'N':'n',
            flagOverflow?'V':'v',   flagBRK?'B':'b',  flagDecimal?'D':'d',
            flagIRQdisable?'I':'i', flagZero?'Z':'z', flagCarry?'C':'c');
 }
 
-uint8_t readByte(uint16_t address) {
-    if (address == OUTPUT_ADDR) {
-        printf(">");
-        memory[address] = getc(stdin);
+// Disassembles count instructions, starting at address.
+// This peeks at memory rather than using readByte(), so that it does not
+//  trigger any memory-mapped I/O or watchpoints.
+uint16_t disassemble(uint16_t address, int count) {
+    char line[DISASM_LINE_SIZE];
+    for (int i = 0; i < count; i++) {
+        uint8_t bytes[3] = { mapPeek(&systemMap, address),
+                             mapPeek(&systemMap, address + 1),
+                             mapPeek(&systemMap, address + 2) };
+        address += disassemble6502(address, bytes, line);
+        printf("]%s\n", line);
+    }
+    return address;
+}
+
+// Runs up to count instructions, printing each one first if tracing is
+//  turned on. Returns the reason it stopped, as run6502() does.
+// Console output is written out after the batch.
+uint8_t run(uint32_t count) {
+    uint8_t reason = STOP_COUNT;
+    if (!tracing) {
+        reason = run6502(count);
+    } else {
+        while (count-- > 0 && reason == STOP_COUNT) {
+            disassemble(programCounter, 1);
+            reason = run6502(1);
+        }
+    }
+    consoleFlush(&console);
+    return reason;
+}
+
+// Called by the core when an interrupt or reset could end WAI or STP, and by
+//  the input thread when a key is pressed.
+void wakeRunLoop() {
+    wakeupSignal(&wakeup);
+}
+
+// Runs until a breakpoint or watchpoint is hit, or the user presses ^A.
+// The terminal is watched by a separate thread, and whatever it has posted is
+//  only looked at between batches, so the batches themselves run flat out.
+// If a clock frequency has been set, each batch is one time slice, and the
+//  host sleeps between them to keep to that frequency.
+// While the processor is idle in WAI, the host sleeps until an interrupt or a
+//  key wakes it, rather than spinning. If it's stopped by STP, or it's waiting
+//  and there's no more input to wake it, nothing can happen until the user
+//  resets it, so free-running stops.
+uint8_t freeRun() {
+    uint8_t reason = STOP_COUNT;
+    bool started = hostInputStart(&hostInput, STDIN_FILENO, wakeRunLoop);
+    if (!started) {
+        printf("]Couldn't watch for input, so this can only be stopped by a breakpoint\n");
+    }
+    if (clockFrequency != 0) {
+        throttleStart(&throttle, clockFrequency);
+    }
+    while (reason == STOP_COUNT) {
+        if (clockFrequency == 0) {
+            reason = run(FREE_RUN_BATCH);
+        } else {
+            reason = runCycles6502(throttle.sliceCycles);
+            consoleFlush(&console);
+            throttleWait(&throttle);
+        }
+        
+        if (reason == STOP_IDLE) {
+            if (hitSTP || !started || hostInputFinished(&hostInput)) {
+                break;
+            }
+            // when throttled, the idle time has already been slept through.
+            if (clockFrequency == 0) {
+                wakeupWait(&wakeup);
+            }
+            reason = STOP_COUNT;
+        }
+        
+        uint16_t key;
+        while (started && hostInputNext(&hostInput, &key)) {
+            if (key == HOST_INPUT_STOP) {
+                reason = STOP_REQUESTED;
+            } else {
+                consoleReceive(&console, key);
+            }
+        }
+    }
+    hostInputStop(&hostInput);
+    if (clockFrequency != 0) {
+        throttleReport(&throttle, stdout);
+    }
+    return reason;
+}
+
+// Tells the user why execution stopped, if it was for any reason other than
+//  running out of instructions.
+void reportStop(uint8_t reason) {
+    if (reason == STOP_BREAKPOINT) {
+        printf("]Breakpoint hit!\n");
+    } else if (reason == STOP_REQUESTED) {
+        printf("]Stopped\n");
+    } else if (reason == STOP_IDLE) {
+        printf("]Processor is idle: %s\n", hitSTP ? "stopped by STP" : "waiting in WAI");
+    } else if (reason == STOP_WATCHPOINT) {
+        printf("]Watchpoint hit: %s $%04X\n",
+               (systemMap.watchHitKind == WATCH_READ) ? "read from" : "write to",
+               systemMap.watchHitAddress);
     }
-    return memory[address];
+}
+
+// Sets up the memory map: RAM everywhere, with the console and VIA on top of
+//  it.
+void setupMemory() {
+    mapInit(&systemMap);
+    mapRAM(&systemMap, 0x0000, MEMORY_SIZE, memory);
+    consoleInit(&console, &systemMap, CONSOLE_BASE, STDIN_FILENO, STDOUT_FILENO);
+    viaInit(&via, &systemMap, VIA_BASE);
+    attachMemoryMap(&systemMap);
+    wakeupInit(&wakeup);
+    setWakeHandler6502(wakeRunLoop);
+}
+
+uint8_t readByte(uint16_t address) {
+    return mapRead(&systemMap, address);
 }
 
 void writeByte(uint16_t address, uint8_t data){
-    if (address == OUTPUT_ADDR) {
-        printf("%c", data);
+    mapWrite(&systemMap, address, data);
+}
+
+// b                            - list breakpoints and watchpoints
+// b aaaa [condition] [#count]  - set a breakpoint
+void breakCommand(const char *args) {
+    char condText[BUF_SIZE] = "";
+    char countText[BUF_SIZE] = "";
+    unsigned int address;
+    int matched = sscanf(args, "%x %s %s", &address, condText, countText);
+    
+    if (matched < 1) {
+        char text[24];
+        for (int i = 0; i < breakpointCount; i++) {
+            formatCondition(&breakpoints[i].condition, text);
+            printf("]Breakpoint at $%04X %s (hit %u of %u)\n", breakpoints[i].address,
+                   text, breakpoints[i].hits, breakpoints[i].stopAfter);
+        }
+        for (int i = 0; i < systemMap.watchpointCount; i++) {
+            const Watchpoint &watch = systemMap.watchpoints[i];
+            printf("]Watchpoint on $%04X-$%04X %s%s\n", watch.start, watch.end,
+                   (watch.kind & WATCH_READ) ? "r" : "", (watch.kind & WATCH_WRITE) ? "w" : "");
+        }
+        return;
+    }
+    
+    // the hit count may come with or without a condition in front of it
+    if (condText[0] == '#') {
+        strcpy(countText, condText);
+        condText[0] = '\0';
+    }
+    Condition condition;
+    condition.operand = COND_NONE;
+    if (condText[0] != '\0' && !parseCondition(condText, &condition)) {
+        printf("]Couldn't understand condition %s\n", condText);
+        return;
+    }
+    uint32_t stopAfter = 1;
+    if (countText[0] == '#') {
+        stopAfter = strtoul(countText + 1, NULL, 10);
+    }
+    if (addBreakpoint(address, &condition, stopAfter)) {
+        printf("]Set breakpoint at address %04X\n", address);
+    } else {
+        printf("]Too many breakpoints\n");
+    }
+}
+
+// c [kHz]                      - pace free-running to a clock frequency.
+//                                 0, or nothing, runs flat out.
+void clockCommand(const char *args) {
+    clockFrequency = strtoul(args, NULL, 10) * 1000;
+    if (clockFrequency == 0) {
+        printf("]Free-running as fast as possible\n");
+    } else {
+        printf("]Free-running at %u kHz\n", clockFrequency / 1000);
+    }
+}
+
+// m aaaa bbbb [r|w|rw]         - watch an address range for reads and/or writes
+void watchCommand(const char *args) {
+    unsigned int start, end;
+    char kindText[BUF_SIZE] = "rw";
+    if (sscanf(args, "%x %x %s", &start, &end, kindText) < 2) {
+        printf("]Usage: m aaaa bbbb [r|w|rw]\n");
+        return;
+    }
+    uint8_t kind = 0;
+    if (strchr(kindText, 'r')) kind |= WATCH_READ;
+    if (strchr(kindText, 'w')) kind |= WATCH_WRITE;
+    if (kind == 0 || !mapWatch(&systemMap, start, end, kind)) {
+        printf("]Couldn't set watchpoint\n");
+    } else {
+        printf("]Watching $%04X-$%04X\n", start, end);
     }
-    memory[address] = data;
 }
 
 // loads an Intel Hex (I8HEX) file
@@ -110,15 +328,26 @@ void loadHexFile(char *filename = NULL) {
     reset                       r
     load Intel Hex file         l           - prompts for filename
     set PC                      s aaaa
-    set breakpoint              b aaaa
     write byte                  w aaaa dd
     read byte                   r aaaa
     run for n instructions      x nnnn
     run for one instruction     x
     free-run                    f           - stop this mode with ^A
+    list breakpoints            b
+    set breakpoint              b aaaa [cond] [#n]  - cond like A==$42 or [$0200]!=0.
+                                                      Stops on the nth hit.
+    remove breakpoint           k aaaa
+    remove all breakpoints      k           - also removes watchpoints
+    watch memory                m aaaa bbbb [r|w|rw]
+    set clock frequency         c kkkk      - in kHz, decimal. Free-running is
+                                              paced to this. c 0 runs flat out.
+    disassemble                 d aaaa [nn] - nn instructions, default 16
+    toggle instruction tracing  t
     quit                        q
 */
 int main(int argc, char *argv[]) {
+    setupMemory();
+    
     //autoSim [filename [start addr [breakpoint]]]
     if (argc > 1) {
         // auto-start
@@ -133,17 +362,13 @@ int main(int argc, char *argv[]) {
             //programCounter = atoi(argv[2]);
         }
         // if provided, read in and set the breakpoint
+        uint16_t breakpoint = 0000;
         if (argc > 3) {
             sscanf(argv[3], "%hX", &breakpoint);
         }
-        while (true) {
-            do6502();
-            if (programCounter == breakpoint) {
-                printf("]Breakpoint hit!\n");
-                printRegs();
-                break;
-            }
-        }
+        addBreakpoint(breakpoint);
+        reportStop(freeRun());
+        printRegs();
     }
     
     char cmd;
@@ -152,11 +377,6 @@ int main(int argc, char *argv[]) {
     char buf[BUF_SIZE];
     int matched;
     
-    // set up the non-blocking copy of stdin for the free-running mode
-    //int stdin_NB_FD = dup(STDIN_FILENO);
-    //fcntl(stdin_NB_FD, F_SETFL, (fcntl(stdin_NB_FD, F_GETFL, 0)|O_NONBLOCK));
-    //FILE *stdin_NB = fdopen(stdin_NB_FD, "r");
-    
     //printf("6502 sim\n");
     
     // main program loop
@@ -170,6 +390,17 @@ int main(int argc, char *argv[]) {
             printf("Terminating...\n");
             exit(EXIT_FAILURE);
         }
+        // breakpoints and watchpoints take more complicated arguments
+        if (tolower(buf[0]) == 'b') {
+            breakCommand(buf + 1);
+            continue;
+        } else if (tolower(buf[0]) == 'm') {
+            watchCommand(buf + 1);
+            continue;
+        } else if (tolower(buf[0]) == 'c') {
+            clockCommand(buf + 1);
+            continue;
+        }
         matched = sscanf(buf, "%c %hx %hhx", &cmd, &address, &data);
         
         // act on it
@@ -186,7 +417,8 @@ int main(int argc, char *argv[]) {
                     reset6502(true);
                     break;
                 case 'x':   // execute one
-                    do6502();
+                    consolePoll(&console);
+                    reportStop(run(1));
                     printRegs();
                     break;
                 case 'l':
@@ -201,15 +433,18 @@ int main(int argc, char *argv[]) {
                 case 'v':
                     printRegs();
                     break;
+                case 't':
+                    tracing = !tracing;
+                    printf("]Tracing %s\n", tracing ? "on" : "off");
+                    break;
                 case 'f':
-                    while (true) {
-                        do6502();
-                        if (programCounter == breakpoint) {
-                            printf("]Breakpoint hit!\n");
-                            printRegs();
-                            break;
-                        }
-                    }
+                    reportStop(freeRun());
+                    printRegs();
+                    break;
+                case 'k':
+                    clearBreakpoints();
+                    mapClearWatchpoints(&systemMap);
+                    printf("]Removed all breakpoints and watchpoints\n");
                     break;
                 default:
                     printf("]Unrecognized command\n");
@@ -226,28 +461,27 @@ int main(int argc, char *argv[]) {
                     break;
                 case 'x':
                     printf("]Executing $%X(%i) instructions\n", address, address);
-                    for (unsigned int i = 0; i < address; i++){
-                        do6502();
-                        if (programCounter == breakpoint) {
-                            printf("]Breakpoint hit!\n");
-                            printRegs();
-                            break;
-                        }
-                    }
+                    consolePoll(&console);
+                    reportStop(run(address));
                     printRegs();
                     break;
-                case 'b':
-                    breakpoint = address;
-                    printf("]Set breakpoint at address %04X\n", breakpoint);
+                case 'd':
+                    disassemble(address, 16);
+                    break;
+                case 'k':
+                    removeBreakpoint(address);
+                    printf("]Removed breakpoints at address %04X\n", address);
                     break;
                 default:
                     printf("]Unrecognized command\n");
                     break;
             }
         } else if (matched == 3) {
-            // w
+            // w, d
             if (tolower(cmd) == 'w') {
                 writeByte(address, data);
+            } else if (tolower(cmd) == 'd') {
+                disassemble(address, data);
             } else {
                 printf("]Unrecognized command\n");
             }
@@ -0,0 +1,170 @@
+// breakpoints.cpp - execution breakpoints and breakpoint conditions.
+
+#include "breakpoints.h"
+#include "memory-map.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern uint8_t A, X, Y, stackPointer;
+extern uint16_t programCounter;
+extern bool flagNegative, flagOverflow, flagDecimal, flagIRQdisable, flagZero, flagCarry;
+
+extern uint8_t readByte(uint16_t address);
+
+uint8_t breakpointMap[0x10000 / 8];
+Breakpoint breakpoints[MAX_BREAKPOINTS];
+int breakpointCount = 0;
+
+static uint16_t conditionOperand(const Condition &condition) {
+    switch (condition.operand) {
+        case COND_A:    return A;
+        case COND_X:    return X;
+        case COND_Y:    return Y;
+        case COND_SP:   return stackPointer;
+        case COND_PC:   return programCounter;
+        case COND_P:
+            // the unused and break bits are always pushed as 1
+            return (flagNegative ? 0x80 : 0) | (flagOverflow ? 0x40 : 0) | 0x30 |
+                   (flagDecimal ? 0x08 : 0) | (flagIRQdisable ? 0x04 : 0) |
+                   (flagZero ? 0x02 : 0) | (flagCarry ? 0x01 : 0);
+        case COND_MEM:
+            // avoid triggering memory-mapped I/O if we can
+            if (activeMap != NULL) return mapPeek(activeMap, condition.address);
+            return readByte(condition.address);
+    }
+    return 0;
+}
+
+static bool conditionMet(const Condition &condition) {
+    if (condition.operand == COND_NONE) {
+        return true;
+    }
+    uint16_t operand = conditionOperand(condition);
+    switch (condition.comparison) {
+        case COND_EQ:   return operand == condition.value;
+        case COND_NE:   return operand != condition.value;
+        case COND_LT:   return operand < condition.value;
+        case COND_LE:   return operand <= condition.value;
+        case COND_GT:   return operand > condition.value;
+        case COND_GE:   return operand >= condition.value;
+    }
+    return false;
+}
+
+bool breakpointHit(uint16_t address) {
+    bool stop = false;
+    for (int i = 0; i < breakpointCount; i++) {
+        Breakpoint &breakpoint = breakpoints[i];
+        if (breakpoint.address == address && conditionMet(breakpoint.condition)) {
+            breakpoint.hits++;
+            if (breakpoint.hits >= breakpoint.stopAfter) {
+                stop = true;
+            }
+        }
+    }
+    return stop;
+}
+
+bool addBreakpoint(uint16_t address, const Condition *condition, uint32_t stopAfter) {
+    if (breakpointCount >= MAX_BREAKPOINTS) {
+        return false;
+    }
+    Breakpoint &breakpoint = breakpoints[breakpointCount++];
+    breakpoint.address = address;
+    if (condition != NULL) {
+        breakpoint.condition = *condition;
+    } else {
+        breakpoint.condition.operand = COND_NONE;
+    }
+    breakpoint.hits = 0;
+    breakpoint.stopAfter = (stopAfter > 0) ? stopAfter : 1;
+    breakpointMap[address >> 3] |= 1 << (address & 7);
+    return true;
+}
+
+void removeBreakpoint(uint16_t address) {
+    int kept = 0;
+    for (int i = 0; i < breakpointCount; i++) {
+        if (breakpoints[i].address != address) {
+            breakpoints[kept++] = breakpoints[i];
+        }
+    }
+    breakpointCount = kept;
+    breakpointMap[address >> 3] &= ~(1 << (address & 7));
+}
+
+void clearBreakpoints() {
+    breakpointCount = 0;
+    memset(breakpointMap, 0, sizeof(breakpointMap));
+}
+
+// parses a number, hexadecimal if it starts with $, and decimal otherwise.
+static bool parseValue(const char *text, const char **end, uint16_t *value) {
+    char *numberEnd;
+    unsigned long parsed;
+    if (*text == '$') {
+        parsed = strtoul(text + 1, &numberEnd, 16);
+        if (numberEnd == text + 1) return false;
+    } else {
+        parsed = strtoul(text, &numberEnd, 10);
+        if (numberEnd == text) return false;
+    }
+    if (parsed > 0xFFFF) return false;
+    *value = parsed;
+    *end = numberEnd;
+    return true;
+}
+
+bool parseCondition(const char *text, Condition *condition) {
+    const char *p = text;
+    
+    // operand
+    if (*p == '[') {
+        if (!parseValue(p + 1, &p, &condition->address) || *p != ']') return false;
+        condition->operand = COND_MEM;
+        p++;
+    } else if ((p[0] == 'P' || p[0] == 'p') && (p[1] == 'C' || p[1] == 'c')) {
+        condition->operand = COND_PC;
+        p += 2;
+    } else {
+        switch (*p) {
+            case 'A': case 'a': condition->operand = COND_A; break;
+            case 'X': case 'x': condition->operand = COND_X; break;
+            case 'Y': case 'y': condition->operand = COND_Y; break;
+            case 'S': case 's': condition->operand = COND_SP; break;
+            case 'P': case 'p': condition->operand = COND_P; break;
+            default: return false;
+        }
+        p++;
+    }
+    
+    // comparison
+    if (strncmp(p, "==", 2) == 0)       { condition->comparison = COND_EQ; p += 2; }
+    else if (strncmp(p, "!=", 2) == 0)  { condition->comparison = COND_NE; p += 2; }
+    else if (strncmp(p, "<=", 2) == 0)  { condition->comparison = COND_LE; p += 2; }
+    else if (strncmp(p, ">=", 2) == 0)  { condition->comparison = COND_GE; p += 2; }
+    else if (*p == '<')                 { condition->comparison = COND_LT; p++; }
+    else if (*p == '>')                 { condition->comparison = COND_GT; p++; }
+    else return false;
+    
+    // value
+    if (!parseValue(p, &p, &condition->value)) return false;
+    return *p == '\0';
+}
+
+void formatCondition(const Condition *condition, char *buffer) {
+    static const char *operands[] = { "", "A", "X", "Y", "S", "P", "PC", "" };
+    static const char *comparisons[] = { "==", "!=", "<", "<=", ">", ">=" };
+    
+    if (condition->operand == COND_NONE) {
+        buffer[0] = '\0';
+    } else if (condition->operand == COND_MEM) {
+        sprintf(buffer, "[$%04X]%s$%02X", condition->address,
+                comparisons[condition->comparison], condition->value);
+    } else {
+        sprintf(buffer, "%s%s$%02X", operands[condition->operand],
+                comparisons[condition->comparison], condition->value);
+    }
+}
@@ -0,0 +1,85 @@
+// breakpoints.h - execution breakpoints and breakpoint conditions.
+// Breakpoints are kept in a bitmap covering the whole address space, so that
+//  run6502() only has to test one bit per instruction. Only when that bit is
+//  set does it look at the breakpoint's condition and hit count, and if the
+//  condition isn't met it carries on without returning to the caller.
+
+#ifndef BREAKPOINTS_H
+#define BREAKPOINTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAX_BREAKPOINTS 32
+
+// Condition operands. COND_MEM compares the byte at Condition.address.
+#define COND_NONE   0   // always true
+#define COND_A      1
+#define COND_X      2
+#define COND_Y      3
+#define COND_SP     4
+#define COND_P      5   // the status register, as PHP would push it
+#define COND_PC     6
+#define COND_MEM    7
+
+// Condition comparisons
+#define COND_EQ     0
+#define COND_NE     1
+#define COND_LT     2
+#define COND_LE     3
+#define COND_GT     4
+#define COND_GE     5
+
+// A breakpoint condition, compiled down from text like "A==$42" so that it
+//  can be evaluated without leaving run6502().
+struct Condition {
+    uint8_t operand;
+    uint8_t comparison;
+    uint16_t address;   // only used by COND_MEM
+    uint16_t value;
+};
+
+struct Breakpoint {
+    uint16_t address;
+    Condition condition;
+    uint32_t hits;      // number of times the condition has been met
+    uint32_t stopAfter; // stop once hits reaches this. 1 stops on the first hit.
+};
+
+extern uint8_t breakpointMap[0x10000 / 8];
+extern Breakpoint breakpoints[MAX_BREAKPOINTS];
+extern int breakpointCount;
+
+// Returns true if any breakpoint is set at the given address.
+inline bool breakpointAt(uint16_t address) {
+    return breakpointMap[address >> 3] & (1 << (address & 7));
+}
+
+// Called by run6502() when breakpointAt() is true for the program counter.
+// Evaluates the conditions of the breakpoints at that address, updates their
+//  hit counts, and returns true if execution should stop.
+bool breakpointHit(uint16_t address);
+
+// Adds a breakpoint. condition may be NULL for an unconditional breakpoint.
+// Returns false if there is no room left.
+bool addBreakpoint(uint16_t address, const Condition *condition = NULL, uint32_t stopAfter = 1);
+
+// Removes every breakpoint at the given address.
+void removeBreakpoint(uint16_t address);
+
+// Removes all breakpoints.
+void clearBreakpoints();
+
+// Compiles a condition of the form <operand><comparison><value>.
+// operand is one of A, X, Y, S, P, PC, or [$aaaa] for a memory location.
+// comparison is one of ==, !=, <, <=, >, >=.
+// value is hexadecimal if preceded by $, and decimal otherwise.
+// Returns false if the text could not be parsed.
+bool parseCondition(const char *text, Condition *condition);
+
+// Writes a condition back out in the same form parseCondition() accepts.
+//  buffer should be at least 24 bytes long.
+void formatCondition(const Condition *condition, char *buffer);
+
+#endif // ifndef BREAKPOINTS_H
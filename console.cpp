@@ -0,0 +1,109 @@
+// console.cpp - a buffered console device for hosts of the simulator.
+
+#include "console.h"
+
+#include <poll.h>
+#include <stdio.h>
+#include <unistd.h>
+
+static uint8_t consoleStatus(const Console *console) {
+    return CONSOLE_TX_READY | ((console->rxHead != console->rxTail) ? CONSOLE_RX_READY : 0);
+}
+
+static uint8_t consoleRead(void *context, uint16_t address) {
+    Console *console = (Console *)context;
+    switch (address - console->device.start) {
+        case CONSOLE_STATUS:
+            return consoleStatus(console);
+        case CONSOLE_DATA_IN:
+            if (console->rxHead == console->rxTail) {
+                return 0x00;
+            }
+            return console->rx[console->rxTail++ & (CONSOLE_RX_SIZE - 1)];
+    }
+    return 0x00;
+}
+
+static uint8_t consolePeek(void *context, uint16_t address) {
+    Console *console = (Console *)context;
+    switch (address - console->device.start) {
+        case CONSOLE_STATUS:
+            return consoleStatus(console);
+        case CONSOLE_DATA_IN:
+            if (console->rxHead == console->rxTail) {
+                return 0x00;
+            }
+            return console->rx[console->rxTail & (CONSOLE_RX_SIZE - 1)];
+    }
+    return 0x00;
+}
+
+static void consoleWrite(void *context, uint16_t address, uint8_t data) {
+    Console *console = (Console *)context;
+    if (address - console->device.start != CONSOLE_DATA_OUT) {
+        return;
+    }
+    if (console->txHead - console->txTail == CONSOLE_TX_SIZE) {
+        consoleFlush(console);
+    }
+    console->tx[console->txHead++ & (CONSOLE_TX_SIZE - 1)] = data;
+}
+
+void consoleInit(Console *console, MemoryMap *map, uint16_t base, int inFD, int outFD) {
+    console->rxHead = console->rxTail = 0;
+    console->txHead = console->txTail = 0;
+    console->inFD = inFD;
+    console->outFD = outFD;
+    
+    console->device.start = base;
+    console->device.end = base + CONSOLE_DATA_OUT;
+    console->device.read = consoleRead;
+    console->device.write = consoleWrite;
+    console->device.peek = consolePeek;
+    console->device.context = console;
+    mapDevice(map, &console->device);
+}
+
+void consoleFlush(Console *console) {
+    if (console->txHead == console->txTail) {
+        return;
+    }
+    // anything the host has printf()ed needs to come out first
+    fflush(stdout);
+    while (console->txHead != console->txTail) {
+        // write out as much as is contiguous in the buffer in one go
+        uint32_t start = console->txTail & (CONSOLE_TX_SIZE - 1);
+        uint32_t length = console->txHead - console->txTail;
+        if (start + length > CONSOLE_TX_SIZE) {
+            length = CONSOLE_TX_SIZE - start;
+        }
+        ssize_t written = write(console->outFD, &console->tx[start], length);
+        if (written <= 0) {
+            // nowhere for it to go, so drop it rather than spin
+            console->txTail = console->txHead;
+            break;
+        }
+        console->txTail += written;
+    }
+}
+
+void consolePoll(Console *console) {
+    uint32_t space = CONSOLE_RX_SIZE - (console->rxHead - console->rxTail);
+    struct pollfd fd = { console->inFD, POLLIN, 0 };
+    if (space == 0 || poll(&fd, 1, 0) <= 0 || !(fd.revents & POLLIN)) {
+        return;
+    }
+    uint8_t data[CONSOLE_RX_SIZE];
+    ssize_t count = read(console->inFD, data, space);
+    for (ssize_t i = 0; i < count; i++) {
+        consoleReceive(console, data[i]);
+    }
+}
+
+bool consoleReceive(Console *console, uint8_t data) {
+    if (console->rxHead - console->rxTail == CONSOLE_RX_SIZE) {
+        return false;
+    }
+    console->rx[console->rxHead++ & (CONSOLE_RX_SIZE - 1)] = data;
+    return true;
+}
@@ -0,0 +1,56 @@
+// console.h - a buffered console device for hosts of the simulator.
+// The console occupies three bytes of the address space:
+//  base+0  status      bit 0 set when there is input waiting,
+//                      bit 1 set when output can be written (always, since
+//                       the output buffer is flushed when it fills up).
+//  base+1  data in     reading it takes the next byte of input, or 0x00 if
+//                       there is none. It never blocks.
+//  base+2  data out    writing it queues a byte of output.
+// Both directions go through ring buffers. Output is only written to the host
+//  when the buffer fills or the host calls consoleFlush(), and input only
+//  arrives when the host calls consolePoll() or consoleReceive(), so guests
+//  that print a lot don't make a system call per character, and guests
+//  waiting for input poll the status register instead of stalling the host.
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "memory-map.h"
+
+#define CONSOLE_STATUS      0
+#define CONSOLE_DATA_IN     1
+#define CONSOLE_DATA_OUT    2
+
+#define CONSOLE_RX_READY    0x01
+#define CONSOLE_TX_READY    0x02
+
+// Buffer sizes must be powers of two.
+#define CONSOLE_RX_SIZE     256
+#define CONSOLE_TX_SIZE     4096
+
+struct Console {
+    uint8_t rx[CONSOLE_RX_SIZE];
+    uint8_t tx[CONSOLE_TX_SIZE];
+    uint32_t rxHead, rxTail;    // bytes are added at the head and taken from the tail
+    uint32_t txHead, txTail;
+    int inFD, outFD;            // host file descriptors for input and output
+    MappedDevice device;
+};
+
+// Sets up a console with its registers at base, reading from inFD and
+//  writing to outFD, and adds it to the map.
+void consoleInit(Console *console, MemoryMap *map, uint16_t base, int inFD, int outFD);
+
+// Writes out any buffered output.
+void consoleFlush(Console *console);
+
+// Reads any input that is available from inFD without blocking.
+void consolePoll(Console *console);
+
+// Queues a byte of input. Returns false if the input buffer is full.
+bool consoleReceive(Console *console, uint8_t data);
+
+#endif // ifndef CONSOLE_H
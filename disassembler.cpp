@@ -0,0 +1,117 @@
+// disassembler.cpp - table-driven W65C02 disassembler.
+// Everything about the shape of an instruction comes from opcodeTable, so
+//  this only needs to know how each addressing mode is written.
+
+#include "disassembler.h"
+#include "opcode-table.h"
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+static char *putHex8(char *out, uint8_t value) {
+    *out++ = hexDigits[value >> 4];
+    *out++ = hexDigits[value & 0x0F];
+    return out;
+}
+static char *putHex16(char *out, uint16_t value) {
+    out = putHex8(out, value >> 8);
+    return putHex8(out, value & 0xFF);
+}
+static char *putString(char *out, const char *str) {
+    while (*str) {
+        *out++ = *str++;
+    }
+    return out;
+}
+
+uint8_t disassemble6502(uint16_t address, const uint8_t *bytes, char *buffer) {
+    const OpcodeInfo &info = opcodeTable[bytes[0]];
+    char *out = buffer;
+    
+    // address and raw bytes, padded out to a fixed width
+    out = putHex16(out, address);
+    *out++ = ' ';
+    for (int i = 0; i < 3; i++) {
+        *out++ = ' ';
+        if (i < info.length) {
+            out = putHex8(out, bytes[i]);
+        } else {
+            *out++ = ' ';
+            *out++ = ' ';
+        }
+    }
+    *out++ = ' ';
+    *out++ = ' ';
+    
+    out = putString(out, info.mnemonic);
+    if (info.mode != AM_IMP) {
+        *out++ = ' ';
+    }
+    
+    uint16_t operand16 = bytes[1] | (info.length > 2 ? bytes[2] << 8 : 0);
+    switch (info.mode) {
+        case AM_IMP:
+            break;
+        case AM_ACC:
+            *out++ = 'A';
+            break;
+        case AM_IMM:
+            out = putString(out, "#$");
+            out = putHex8(out, bytes[1]);
+            break;
+        case AM_ZP:
+        case AM_ZP_X:
+        case AM_ZP_Y:
+            *out++ = '$';
+            out = putHex8(out, bytes[1]);
+            if (info.mode == AM_ZP_X) out = putString(out, ",X");
+            if (info.mode == AM_ZP_Y) out = putString(out, ",Y");
+            break;
+        case AM_ZP_IND:
+            out = putString(out, "($");
+            out = putHex8(out, bytes[1]);
+            *out++ = ')';
+            break;
+        case AM_ZP_X_IND:
+            out = putString(out, "($");
+            out = putHex8(out, bytes[1]);
+            out = putString(out, ",X)");
+            break;
+        case AM_ZP_IND_Y:
+            out = putString(out, "($");
+            out = putHex8(out, bytes[1]);
+            out = putString(out, "),Y");
+            break;
+        case AM_REL:
+            // the displacement is relative to the address of the next instruction
+            *out++ = '$';
+            out = putHex16(out, address + 2 + (int8_t)bytes[1]);
+            break;
+        case AM_ABS:
+        case AM_ABS_X:
+        case AM_ABS_Y:
+            *out++ = '$';
+            out = putHex16(out, operand16);
+            if (info.mode == AM_ABS_X) out = putString(out, ",X");
+            if (info.mode == AM_ABS_Y) out = putString(out, ",Y");
+            break;
+        case AM_ABS_IND:
+            out = putString(out, "($");
+            out = putHex16(out, operand16);
+            *out++ = ')';
+            break;
+        case AM_ABS_X_IND:
+            out = putString(out, "($");
+            out = putHex16(out, operand16);
+            out = putString(out, ",X)");
+            break;
+        case AM_ZP_REL:
+            *out++ = '$';
+            out = putHex8(out, bytes[1]);
+            out = putString(out, ",$");
+            out = putHex16(out, address + 3 + (int8_t)bytes[2]);
+            break;
+    }
+    *out = '\0';
+    
+    return info.length;
+}
@@ -0,0 +1,25 @@
+// disassembler.h - table-driven W65C02 disassembler.
+
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include <stdint.h>
+
+// The longest line disassemble6502() produces, including the terminating null.
+//  "FFFF  FF FF FF  BBR0 $FF,$FFFF" is 30 characters.
+#define DISASM_LINE_SIZE 32
+
+// Disassembles a single instruction into a caller-supplied buffer.
+// Parameters:
+//  uint16_t address        The address the instruction is located at. Used to
+//                           print the address, and to resolve branch targets.
+//  const uint8_t *bytes    The bytes of the instruction. At least as many bytes
+//                           as the instruction is long must be readable.
+//  char *buffer            Receives the null-terminated line. Must be at least
+//                           DISASM_LINE_SIZE bytes long.
+// Returns the length of the instruction, in bytes.
+// This does no allocation and no formatted I/O, so it is cheap enough to call
+//  for every instruction when tracing.
+uint8_t disassemble6502(uint16_t address, const uint8_t *bytes, char *buffer);
+
+#endif // ifndef DISASSEMBLER_H
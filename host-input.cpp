@@ -0,0 +1,82 @@
+// host-input.cpp - watches the host's terminal from a separate thread while
+//  the simulator is free-running.
+
+#include "host-input.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+// How long the thread waits for input before checking whether it should stop.
+#define HOST_INPUT_POLL_MS 50
+
+static void post(HostInput *input, uint16_t value) {
+    // if the run loop has fallen behind, wait for it rather than losing keys
+    while (!spscPush(&input->queue, value)) {
+        if (!__atomic_load_n(&input->running, __ATOMIC_RELAXED)) {
+            return;
+        }
+        usleep(1000);
+    }
+}
+
+static void *hostInputThread(void *arg) {
+    HostInput *input = (HostInput *)arg;
+    struct pollfd fd = { input->fd, POLLIN, 0 };
+    
+    while (__atomic_load_n(&input->running, __ATOMIC_RELAXED)) {
+        if (poll(&fd, 1, HOST_INPUT_POLL_MS) <= 0 || !(fd.revents & (POLLIN | POLLHUP))) {
+            continue;
+        }
+        uint8_t buf[64];
+        ssize_t count = read(input->fd, buf, sizeof(buf));
+        if (count <= 0) {
+            // end of input. There's nothing more to watch.
+            break;
+        }
+        for (ssize_t i = 0; i < count; i++) {
+            post(input, (buf[i] == HOST_INPUT_STOP_KEY) ? HOST_INPUT_STOP : buf[i]);
+        }
+        if (input->notify != NULL) input->notify();
+    }
+    __atomic_store_n(&input->finished, true, __ATOMIC_RELEASE);
+    if (input->notify != NULL) input->notify();
+    return NULL;
+}
+
+bool hostInputStart(HostInput *input, int fd, void (*notify)()) {
+    spscInit(&input->queue);
+    input->fd = fd;
+    input->notify = notify;
+    input->finished = false;
+    input->restoreTerminal = false;
+    
+    // turn off line buffering and echo, so that keys arrive as they are
+    //  pressed, and the guest decides what to echo.
+    if (isatty(fd) && tcgetattr(fd, &input->savedTerminal) == 0) {
+        struct termios raw = input->savedTerminal;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        if (tcsetattr(fd, TCSANOW, &raw) == 0) {
+            input->restoreTerminal = true;
+        }
+    }
+    
+    __atomic_store_n(&input->running, true, __ATOMIC_RELAXED);
+    if (pthread_create(&input->thread, NULL, hostInputThread, input) != 0) {
+        __atomic_store_n(&input->running, false, __ATOMIC_RELAXED);
+        hostInputStop(input);
+        return false;
+    }
+    return true;
+}
+
+void hostInputStop(HostInput *input) {
+    if (__atomic_exchange_n(&input->running, false, __ATOMIC_RELAXED)) {
+        pthread_join(input->thread, NULL);
+    }
+    if (input->restoreTerminal) {
+        tcsetattr(input->fd, TCSANOW, &input->savedTerminal);
+        input->restoreTerminal = false;
+    }
+}
@@ -0,0 +1,55 @@
+// host-input.h - watches the host's terminal from a separate thread while the
+//  simulator is free-running.
+// Keystrokes are posted to the run loop through a lock-free queue, so the run
+//  loop never blocks on, or even polls, the terminal itself. It just drains
+//  the queue between batches of instructions.
+// ^A is not passed on to the guest. It posts HOST_INPUT_STOP instead, which
+//  asks the run loop to stop free-running.
+// If the run loop might be asleep, waiting for something to happen, it can pass
+//  a notify function, which is called after anything is posted, and once more
+//  when the input runs out.
+
+#ifndef HOST_INPUT_H
+#define HOST_INPUT_H
+
+#include <pthread.h>
+#include <termios.h>
+
+#include "spsc-queue.h"
+
+// The key that stops free-running, and what it's posted to the queue as.
+#define HOST_INPUT_STOP_KEY 0x01
+#define HOST_INPUT_STOP     0x100
+
+struct HostInput {
+    SPSCQueue queue;        // keystrokes, and HOST_INPUT_STOP
+    pthread_t thread;
+    int fd;
+    bool running;           // accessed atomically
+    bool finished;          // accessed atomically. Set when the input runs out
+    void (*notify)();       // called from the thread after posting. May be NULL
+    bool restoreTerminal;   // set if terminal needs to be put back the way it was
+    struct termios savedTerminal;
+};
+
+// Starts watching fd. If fd is a terminal, it is switched to unbuffered input
+//  without echo until hostInputStop() is called.
+// Returns false if the thread couldn't be started.
+bool hostInputStart(HostInput *input, int fd, void (*notify)() = NULL);
+
+// Stops the thread, and restores the terminal.
+void hostInputStop(HostInput *input);
+
+// Takes the next posted value off the queue. Called by the run loop.
+// Returns false if there isn't one.
+inline bool hostInputNext(HostInput *input, uint16_t *value) {
+    return spscPop(&input->queue, value);
+}
+
+// Returns true once there is nothing more to read, and so nothing more will be
+//  posted.
+inline bool hostInputFinished(HostInput *input) {
+    return __atomic_load_n(&input->finished, __ATOMIC_ACQUIRE);
+}
+
+#endif // ifndef HOST_INPUT_H
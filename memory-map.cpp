@@ -0,0 +1,149 @@
+// memory-map.cpp - a page-table memory map for hosts of the simulator.
+
+#include "memory-map.h"
+#include "simulieren-6502.h"
+
+#include <stddef.h>
+
+MemoryMap *activeMap = NULL;
+
+void attachMemoryMap(MemoryMap *map) {
+    activeMap = map;
+}
+
+void mapInit(MemoryMap *map) {
+    for (int i = 0; i < PAGE_COUNT; i++) {
+        map->pages[i].data = NULL;
+        map->pages[i].flags = PAGE_UNMAPPED;
+    }
+    map->devices = NULL;
+    map->watchpointCount = 0;
+    map->watchHitAddress = 0;
+    map->watchHitKind = 0;
+}
+
+static void mapBacking(MemoryMap *map, uint16_t start, uint32_t length, uint8_t *backing, uint8_t flags) {
+    for (uint32_t offset = 0; offset < length; offset += PAGE_SIZE) {
+        MemoryPage &page = map->pages[(start + offset) >> 8];
+        page.data = backing + offset;
+        // devices and watchpoints stay where they were
+        page.flags = (page.flags & (PAGE_DEVICE | PAGE_WATCH_READ | PAGE_WATCH_WRITE)) | flags;
+    }
+}
+
+void mapRAM(MemoryMap *map, uint16_t start, uint32_t length, uint8_t *backing) {
+    mapBacking(map, start, length, backing, 0);
+}
+
+void mapROM(MemoryMap *map, uint16_t start, uint32_t length, uint8_t *backing) {
+    mapBacking(map, start, length, backing, PAGE_READONLY);
+}
+
+void mapDevice(MemoryMap *map, MappedDevice *device) {
+    device->next = map->devices;
+    map->devices = device;
+    for (int page = device->start >> 8; page <= device->end >> 8; page++) {
+        map->pages[page].flags |= PAGE_DEVICE;
+    }
+}
+
+// recomputes the watch flags on every page from the list of watchpoints
+static void updateWatchFlags(MemoryMap *map) {
+    for (int i = 0; i < PAGE_COUNT; i++) {
+        map->pages[i].flags &= ~(PAGE_WATCH_READ | PAGE_WATCH_WRITE);
+    }
+    for (int i = 0; i < map->watchpointCount; i++) {
+        const Watchpoint &watch = map->watchpoints[i];
+        for (int page = watch.start >> 8; page <= watch.end >> 8; page++) {
+            if (watch.kind & WATCH_READ) map->pages[page].flags |= PAGE_WATCH_READ;
+            if (watch.kind & WATCH_WRITE) map->pages[page].flags |= PAGE_WATCH_WRITE;
+        }
+    }
+}
+
+bool mapWatch(MemoryMap *map, uint16_t start, uint16_t end, uint8_t kind) {
+    if (map->watchpointCount >= MAX_WATCHPOINTS || end < start) {
+        return false;
+    }
+    Watchpoint &watch = map->watchpoints[map->watchpointCount++];
+    watch.start = start;
+    watch.end = end;
+    watch.kind = kind;
+    updateWatchFlags(map);
+    return true;
+}
+
+void mapClearWatchpoints(MemoryMap *map) {
+    map->watchpointCount = 0;
+    updateWatchFlags(map);
+}
+
+static void checkWatchpoints(MemoryMap *map, uint16_t address, uint8_t kind) {
+    for (int i = 0; i < map->watchpointCount; i++) {
+        const Watchpoint &watch = map->watchpoints[i];
+        if ((watch.kind & kind) && address >= watch.start && address <= watch.end) {
+            map->watchHitAddress = address;
+            map->watchHitKind = kind;
+            requestStop6502(STOP_WATCHPOINT);
+            return;
+        }
+    }
+}
+
+static MappedDevice *findDevice(const MemoryMap *map, uint16_t address) {
+    for (MappedDevice *device = map->devices; device != NULL; device = device->next) {
+        if (address >= device->start && address <= device->end) {
+            return device;
+        }
+    }
+    return NULL;
+}
+
+uint8_t mapReadSlow(MemoryMap *map, uint16_t address) {
+    const MemoryPage &page = map->pages[address >> 8];
+    if (page.flags & PAGE_WATCH_READ) {
+        checkWatchpoints(map, address, WATCH_READ);
+    }
+    if (page.flags & PAGE_DEVICE) {
+        MappedDevice *device = findDevice(map, address);
+        if (device != NULL) {
+            return device->read(device->context, address);
+        }
+    }
+    if (page.flags & PAGE_UNMAPPED) {
+        return 0xFF;
+    }
+    return page.data[address & 0xFF];
+}
+
+void mapWriteSlow(MemoryMap *map, uint16_t address, uint8_t data) {
+    const MemoryPage &page = map->pages[address >> 8];
+    if (page.flags & PAGE_WATCH_WRITE) {
+        checkWatchpoints(map, address, WATCH_WRITE);
+    }
+    if (page.flags & PAGE_DEVICE) {
+        MappedDevice *device = findDevice(map, address);
+        if (device != NULL) {
+            device->write(device->context, address, data);
+            return;
+        }
+    }
+    if (page.flags & (PAGE_UNMAPPED | PAGE_READONLY)) {
+        return;
+    }
+    page.data[address & 0xFF] = data;
+}
+
+uint8_t mapPeek(const MemoryMap *map, uint16_t address) {
+    const MemoryPage &page = map->pages[address >> 8];
+    if (page.flags & PAGE_DEVICE) {
+        MappedDevice *device = findDevice(map, address);
+        if (device != NULL) {
+            return (device->peek != NULL) ? device->peek(device->context, address) : 0xFF;
+        }
+    }
+    if (page.flags & PAGE_UNMAPPED) {
+        return 0xFF;
+    }
+    return page.data[address & 0xFF];
+}
@@ -0,0 +1,121 @@
+// memory-map.h - a page-table memory map for hosts of the simulator.
+// The simulator itself only ever calls readByte() and writeByte(), which the
+//  host provides. A host can implement those with mapRead() and mapWrite(),
+//  and describe its memory as a table of 256-byte pages instead of a chain of
+//  if statements.
+// Plain RAM and ROM pages are accessed straight from their backing store.
+//  Anything else - memory-mapped devices, unmapped pages, writes to ROM, and
+//  watched pages - is flagged on the page, and goes through mapReadSlow() or
+//  mapWriteSlow(). Pages without any of those flags pay nothing extra.
+
+#ifndef MEMORY_MAP_H
+#define MEMORY_MAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PAGE_SIZE   0x100
+#define PAGE_COUNT  0x100
+
+// Page flags
+#define PAGE_UNMAPPED       0x01    // no backing store. Reads return 0xFF.
+#define PAGE_READONLY       0x02    // writes are ignored
+#define PAGE_DEVICE         0x04    // at least one device overlaps this page
+#define PAGE_WATCH_READ     0x08    // at least one read watchpoint overlaps this page
+#define PAGE_WATCH_WRITE    0x10    // at least one write watchpoint overlaps this page
+
+// Any of these flags send an access down the slow path.
+#define PAGE_SLOW_READ  (PAGE_UNMAPPED | PAGE_DEVICE | PAGE_WATCH_READ)
+#define PAGE_SLOW_WRITE (PAGE_UNMAPPED | PAGE_READONLY | PAGE_DEVICE | PAGE_WATCH_WRITE)
+
+// Watchpoint kinds
+#define WATCH_READ  0x01
+#define WATCH_WRITE 0x02
+
+#define MAX_WATCHPOINTS 16
+
+// A memory-mapped device, covering the addresses start to end inclusive.
+// Accesses within that range go to the device instead of the page's backing
+//  store. peek may be NULL; it should return what a read would, without any
+//  side effects, and is used by debugging code.
+struct MappedDevice {
+    uint16_t start, end;
+    uint8_t (*read)(void *context, uint16_t address);
+    void (*write)(void *context, uint16_t address, uint8_t data);
+    uint8_t (*peek)(void *context, uint16_t address);
+    void *context;
+    MappedDevice *next;     // used by the map. Set by mapDevice().
+};
+
+struct MemoryPage {
+    uint8_t *data;          // backing store, indexed by the low byte of the address
+    uint8_t flags;
+};
+
+struct Watchpoint {
+    uint16_t start, end;    // inclusive
+    uint8_t kind;           // WATCH_READ and/or WATCH_WRITE
+};
+
+struct MemoryMap {
+    MemoryPage pages[PAGE_COUNT];
+    MappedDevice *devices;
+    Watchpoint watchpoints[MAX_WATCHPOINTS];
+    int watchpointCount;
+    // The address and kind of the last watchpoint that was hit.
+    uint16_t watchHitAddress;
+    uint8_t watchHitKind;
+};
+
+// The map the simulator's host is using, if it has attached one with
+//  attachMemoryMap(). Debugging code uses this to look at memory without
+//  going through readByte().
+extern MemoryMap *activeMap;
+
+// Tells the simulator which map the host's readByte() and writeByte() use.
+void attachMemoryMap(MemoryMap *map);
+
+// Initialises a map with every page unmapped.
+void mapInit(MemoryMap *map);
+
+// Maps length bytes of backing store at start. start and length must be
+//  multiples of PAGE_SIZE.
+void mapRAM(MemoryMap *map, uint16_t start, uint32_t length, uint8_t *backing);
+void mapROM(MemoryMap *map, uint16_t start, uint32_t length, uint8_t *backing);
+
+// Adds a device to the map. Addresses in the device's range that are also
+//  covered by RAM or ROM go to the device.
+void mapDevice(MemoryMap *map, MappedDevice *device);
+
+// Adds a watchpoint over start to end inclusive. Any access of the given kind
+//  in that range stops run6502() with STOP_WATCHPOINT once the current
+//  instruction has finished. Returns false if there is no room left.
+bool mapWatch(MemoryMap *map, uint16_t start, uint16_t end, uint8_t kind);
+
+// Removes all watchpoints.
+void mapClearWatchpoints(MemoryMap *map);
+
+uint8_t mapReadSlow(MemoryMap *map, uint16_t address);
+void mapWriteSlow(MemoryMap *map, uint16_t address, uint8_t data);
+
+inline uint8_t mapRead(MemoryMap *map, uint16_t address) {
+    const MemoryPage &page = map->pages[address >> 8];
+    if (!(page.flags & PAGE_SLOW_READ)) {
+        return page.data[address & 0xFF];
+    }
+    return mapReadSlow(map, address);
+}
+
+inline void mapWrite(MemoryMap *map, uint16_t address, uint8_t data) {
+    const MemoryPage &page = map->pages[address >> 8];
+    if (!(page.flags & PAGE_SLOW_WRITE)) {
+        page.data[address & 0xFF] = data;
+        return;
+    }
+    mapWriteSlow(map, address, data);
+}
+
+// Reads a byte without triggering devices or watchpoints.
+uint8_t mapPeek(const MemoryMap *map, uint16_t address);
+
+#endif // ifndef MEMORY_MAP_H
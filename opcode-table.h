@@ -0,0 +1,339 @@
+// opcode-table.h - per-opcode instruction metadata for the W65C02.
+// This is the single description of what each of the 256 opcodes looks like:
+//  its mnemonic, addressing mode, length in bytes, base cycle count, and the
+//  OPF_ flags below. The
+//  disassembler and the tracing output are driven from it, and anything else
+//  that needs to know the shape of an instruction should look here rather
+//  than re-deriving it from the switch in do6502().
+// Cycle counts are the base counts from the W65C02 datasheet. They do not
+//  include the extra cycles for a taken branch, a page crossing, or decimal
+//  mode; do6502() adds those as it goes.
+
+#ifndef OPCODE_TABLE_H
+#define OPCODE_TABLE_H
+
+#include <stdint.h>
+
+#include "opcodes.h"
+
+// Addressing modes, as they appear in the assembler syntax.
+enum AddrMode : uint8_t {
+    AM_IMP,         // implied              NOP
+    AM_ACC,         // accumulator          ASL A
+    AM_IMM,         // immediate            LDA #$12
+    AM_ZP,          // zero page            LDA $12
+    AM_ZP_X,        // zero page, X         LDA $12,X
+    AM_ZP_Y,        // zero page, Y         LDX $12,Y
+    AM_ZP_IND,      // zero page indirect   LDA ($12)
+    AM_ZP_X_IND,    // indexed indirect     LDA ($12,X)
+    AM_ZP_IND_Y,    // indirect indexed     LDA ($12),Y
+    AM_REL,         // relative             BNE $1234
+    AM_ABS,         // absolute             LDA $1234
+    AM_ABS_X,       // absolute, X          LDA $1234,X
+    AM_ABS_Y,       // absolute, Y          LDA $1234,Y
+    AM_ABS_IND,     // absolute indirect    JMP ($1234)
+    AM_ABS_X_IND,   // indexed absolute indirect  JMP ($1234,X)
+    AM_ZP_REL       // zero page, relative  BBR0 $12,$1234
+};
+
+// Opcode flags
+#define OPF_PAGE_PENALTY    0x01    // takes an extra cycle if indexing crosses a page
+#define OPF_BRANCH          0x02    // relative branch, including BBR and BBS
+#define OPF_WRITE           0x04    // writes to memory, other than the stack
+#define OPF_STACK           0x08    // pushes or pulls
+#define OPF_JUMP            0x10    // transfers control other than by a branch
+#define OPF_HALT            0x20    // WAI and STP
+
+struct OpcodeInfo {
+    const char *mnemonic;
+    AddrMode mode;
+    uint8_t length;     // in bytes, including the opcode
+    uint8_t cycles;     // base cycle count
+    uint8_t flags;      // OPF_ flags
+};
+
+// BRK is listed as a 2-byte instruction, since do6502() skips the signature
+//  byte. The W65C02's undefined opcodes are listed as the NOPs they execute as.
+constexpr OpcodeInfo opcodeTable[256] = {
+    /* 00 */ { "BRK",  AM_IMM,       2, 7, OPF_STACK | OPF_JUMP },
+    /* 01 */ { "ORA",  AM_ZP_X_IND,  2, 6, 0 },
+    /* 02 */ { "NOP",  AM_IMM,       2, 2, 0 },
+    /* 03 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 04 */ { "TSB",  AM_ZP,        2, 5, OPF_WRITE },
+    /* 05 */ { "ORA",  AM_ZP,        2, 3, 0 },
+    /* 06 */ { "ASL",  AM_ZP,        2, 5, OPF_WRITE },
+    /* 07 */ { "RMB0", AM_ZP,        2, 5, OPF_WRITE },
+    /* 08 */ { "PHP",  AM_IMP,       1, 3, OPF_STACK },
+    /* 09 */ { "ORA",  AM_IMM,       2, 2, 0 },
+    /* 0A */ { "ASL",  AM_ACC,       1, 2, 0 },
+    /* 0B */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 0C */ { "TSB",  AM_ABS,       3, 6, OPF_WRITE },
+    /* 0D */ { "ORA",  AM_ABS,       3, 4, 0 },
+    /* 0E */ { "ASL",  AM_ABS,       3, 6, OPF_WRITE },
+    /* 0F */ { "BBR0", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* 10 */ { "BPL",  AM_REL,       2, 2, OPF_BRANCH },
+    /* 11 */ { "ORA",  AM_ZP_IND_Y,  2, 5, OPF_PAGE_PENALTY },
+    /* 12 */ { "ORA",  AM_ZP_IND,    2, 5, 0 },
+    /* 13 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 14 */ { "TRB",  AM_ZP,        2, 5, OPF_WRITE },
+    /* 15 */ { "ORA",  AM_ZP_X,      2, 4, 0 },
+    /* 16 */ { "ASL",  AM_ZP_X,      2, 6, OPF_WRITE },
+    /* 17 */ { "RMB1", AM_ZP,        2, 5, OPF_WRITE },
+    /* 18 */ { "CLC",  AM_IMP,       1, 2, 0 },
+    /* 19 */ { "ORA",  AM_ABS_Y,     3, 4, OPF_PAGE_PENALTY },
+    /* 1A */ { "INC",  AM_ACC,       1, 2, 0 },
+    /* 1B */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 1C */ { "TRB",  AM_ABS,       3, 6, OPF_WRITE },
+    /* 1D */ { "ORA",  AM_ABS_X,     3, 4, OPF_PAGE_PENALTY },
+    /* 1E */ { "ASL",  AM_ABS_X,     3, 6, OPF_PAGE_PENALTY | OPF_WRITE },
+    /* 1F */ { "BBR1", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* 20 */ { "JSR",  AM_ABS,       3, 6, OPF_STACK | OPF_JUMP },
+    /* 21 */ { "AND",  AM_ZP_X_IND,  2, 6, 0 },
+    /* 22 */ { "NOP",  AM_IMM,       2, 2, 0 },
+    /* 23 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 24 */ { "BIT",  AM_ZP,        2, 3, 0 },
+    /* 25 */ { "AND",  AM_ZP,        2, 3, 0 },
+    /* 26 */ { "ROL",  AM_ZP,        2, 5, OPF_WRITE },
+    /* 27 */ { "RMB2", AM_ZP,        2, 5, OPF_WRITE },
+    /* 28 */ { "PLP",  AM_IMP,       1, 4, OPF_STACK },
+    /* 29 */ { "AND",  AM_IMM,       2, 2, 0 },
+    /* 2A */ { "ROL",  AM_ACC,       1, 2, 0 },
+    /* 2B */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 2C */ { "BIT",  AM_ABS,       3, 4, 0 },
+    /* 2D */ { "AND",  AM_ABS,       3, 4, 0 },
+    /* 2E */ { "ROL",  AM_ABS,       3, 6, OPF_WRITE },
+    /* 2F */ { "BBR2", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* 30 */ { "BMI",  AM_REL,       2, 2, OPF_BRANCH },
+    /* 31 */ { "AND",  AM_ZP_IND_Y,  2, 5, OPF_PAGE_PENALTY },
+    /* 32 */ { "AND",  AM_ZP_IND,    2, 5, 0 },
+    /* 33 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 34 */ { "BIT",  AM_ZP_X,      2, 4, 0 },
+    /* 35 */ { "AND",  AM_ZP_X,      2, 4, 0 },
+    /* 36 */ { "ROL",  AM_ZP_X,      2, 6, OPF_WRITE },
+    /* 37 */ { "RMB3", AM_ZP,        2, 5, OPF_WRITE },
+    /* 38 */ { "SEC",  AM_IMP,       1, 2, 0 },
+    /* 39 */ { "AND",  AM_ABS_Y,     3, 4, OPF_PAGE_PENALTY },
+    /* 3A */ { "DEC",  AM_ACC,       1, 2, 0 },
+    /* 3B */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 3C */ { "BIT",  AM_ABS_X,     3, 4, OPF_PAGE_PENALTY },
+    /* 3D */ { "AND",  AM_ABS_X,     3, 4, OPF_PAGE_PENALTY },
+    /* 3E */ { "ROL",  AM_ABS_X,     3, 6, OPF_PAGE_PENALTY | OPF_WRITE },
+    /* 3F */ { "BBR3", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* 40 */ { "RTI",  AM_IMP,       1, 6, OPF_STACK | OPF_JUMP },
+    /* 41 */ { "EOR",  AM_ZP_X_IND,  2, 6, 0 },
+    /* 42 */ { "NOP",  AM_IMM,       2, 2, 0 },
+    /* 43 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 44 */ { "NOP",  AM_ZP,        2, 3, 0 },
+    /* 45 */ { "EOR",  AM_ZP,        2, 3, 0 },
+    /* 46 */ { "LSR",  AM_ZP,        2, 5, OPF_WRITE },
+    /* 47 */ { "RMB4", AM_ZP,        2, 5, OPF_WRITE },
+    /* 48 */ { "PHA",  AM_IMP,       1, 3, OPF_STACK },
+    /* 49 */ { "EOR",  AM_IMM,       2, 2, 0 },
+    /* 4A */ { "LSR",  AM_ACC,       1, 2, 0 },
+    /* 4B */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 4C */ { "JMP",  AM_ABS,       3, 3, OPF_JUMP },
+    /* 4D */ { "EOR",  AM_ABS,       3, 4, 0 },
+    /* 4E */ { "LSR",  AM_ABS,       3, 6, OPF_WRITE },
+    /* 4F */ { "BBR4", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* 50 */ { "BVC",  AM_REL,       2, 2, OPF_BRANCH },
+    /* 51 */ { "EOR",  AM_ZP_IND_Y,  2, 5, OPF_PAGE_PENALTY },
+    /* 52 */ { "EOR",  AM_ZP_IND,    2, 5, 0 },
+    /* 53 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 54 */ { "NOP",  AM_ZP_X,      2, 4, 0 },
+    /* 55 */ { "EOR",  AM_ZP_X,      2, 4, 0 },
+    /* 56 */ { "LSR",  AM_ZP_X,      2, 6, OPF_WRITE },
+    /* 57 */ { "RMB5", AM_ZP,        2, 5, OPF_WRITE },
+    /* 58 */ { "CLI",  AM_IMP,       1, 2, 0 },
+    /* 59 */ { "EOR",  AM_ABS_Y,     3, 4, OPF_PAGE_PENALTY },
+    /* 5A */ { "PHY",  AM_IMP,       1, 3, OPF_STACK },
+    /* 5B */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 5C */ { "NOP",  AM_ABS,       3, 8, 0 },
+    /* 5D */ { "EOR",  AM_ABS_X,     3, 4, OPF_PAGE_PENALTY },
+    /* 5E */ { "LSR",  AM_ABS_X,     3, 6, OPF_PAGE_PENALTY | OPF_WRITE },
+    /* 5F */ { "BBR5", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* 60 */ { "RTS",  AM_IMP,       1, 6, OPF_STACK | OPF_JUMP },
+    /* 61 */ { "ADC",  AM_ZP_X_IND,  2, 6, 0 },
+    /* 62 */ { "NOP",  AM_IMM,       2, 2, 0 },
+    /* 63 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 64 */ { "STZ",  AM_ZP,        2, 3, OPF_WRITE },
+    /* 65 */ { "ADC",  AM_ZP,        2, 3, 0 },
+    /* 66 */ { "ROR",  AM_ZP,        2, 5, OPF_WRITE },
+    /* 67 */ { "RMB6", AM_ZP,        2, 5, OPF_WRITE },
+    /* 68 */ { "PLA",  AM_IMP,       1, 4, OPF_STACK },
+    /* 69 */ { "ADC",  AM_IMM,       2, 2, 0 },
+    /* 6A */ { "ROR",  AM_ACC,       1, 2, 0 },
+    /* 6B */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 6C */ { "JMP",  AM_ABS_IND,   3, 6, OPF_JUMP },
+    /* 6D */ { "ADC",  AM_ABS,       3, 4, 0 },
+    /* 6E */ { "ROR",  AM_ABS,       3, 6, OPF_WRITE },
+    /* 6F */ { "BBR6", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* 70 */ { "BVS",  AM_REL,       2, 2, OPF_BRANCH },
+    /* 71 */ { "ADC",  AM_ZP_IND_Y,  2, 5, OPF_PAGE_PENALTY },
+    /* 72 */ { "ADC",  AM_ZP_IND,    2, 5, 0 },
+    /* 73 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 74 */ { "STZ",  AM_ZP_X,      2, 4, OPF_WRITE },
+    /* 75 */ { "ADC",  AM_ZP_X,      2, 4, 0 },
+    /* 76 */ { "ROR",  AM_ZP_X,      2, 6, OPF_WRITE },
+    /* 77 */ { "RMB7", AM_ZP,        2, 5, OPF_WRITE },
+    /* 78 */ { "SEI",  AM_IMP,       1, 2, 0 },
+    /* 79 */ { "ADC",  AM_ABS_Y,     3, 4, OPF_PAGE_PENALTY },
+    /* 7A */ { "PLY",  AM_IMP,       1, 4, OPF_STACK },
+    /* 7B */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 7C */ { "JMP",  AM_ABS_X_IND, 3, 6, OPF_JUMP },
+    /* 7D */ { "ADC",  AM_ABS_X,     3, 4, OPF_PAGE_PENALTY },
+    /* 7E */ { "ROR",  AM_ABS_X,     3, 6, OPF_PAGE_PENALTY | OPF_WRITE },
+    /* 7F */ { "BBR7", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* 80 */ { "BRA",  AM_REL,       2, 3, OPF_BRANCH },
+    /* 81 */ { "STA",  AM_ZP_X_IND,  2, 6, OPF_WRITE },
+    /* 82 */ { "NOP",  AM_IMM,       2, 2, 0 },
+    /* 83 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 84 */ { "STY",  AM_ZP,        2, 3, OPF_WRITE },
+    /* 85 */ { "STA",  AM_ZP,        2, 3, OPF_WRITE },
+    /* 86 */ { "STX",  AM_ZP,        2, 3, OPF_WRITE },
+    /* 87 */ { "SMB0", AM_ZP,        2, 5, OPF_WRITE },
+    /* 88 */ { "DEY",  AM_IMP,       1, 2, 0 },
+    /* 89 */ { "BIT",  AM_IMM,       2, 2, 0 },
+    /* 8A */ { "TXA",  AM_IMP,       1, 2, 0 },
+    /* 8B */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 8C */ { "STY",  AM_ABS,       3, 4, OPF_WRITE },
+    /* 8D */ { "STA",  AM_ABS,       3, 4, OPF_WRITE },
+    /* 8E */ { "STX",  AM_ABS,       3, 4, OPF_WRITE },
+    /* 8F */ { "BBS0", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* 90 */ { "BCC",  AM_REL,       2, 2, OPF_BRANCH },
+    /* 91 */ { "STA",  AM_ZP_IND_Y,  2, 6, OPF_WRITE },
+    /* 92 */ { "STA",  AM_ZP_IND,    2, 5, OPF_WRITE },
+    /* 93 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 94 */ { "STY",  AM_ZP_X,      2, 4, OPF_WRITE },
+    /* 95 */ { "STA",  AM_ZP_X,      2, 4, OPF_WRITE },
+    /* 96 */ { "STX",  AM_ZP_Y,      2, 4, OPF_WRITE },
+    /* 97 */ { "SMB1", AM_ZP,        2, 5, OPF_WRITE },
+    /* 98 */ { "TYA",  AM_IMP,       1, 2, 0 },
+    /* 99 */ { "STA",  AM_ABS_Y,     3, 5, OPF_WRITE },
+    /* 9A */ { "TXS",  AM_IMP,       1, 2, 0 },
+    /* 9B */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* 9C */ { "STZ",  AM_ABS,       3, 4, OPF_WRITE },
+    /* 9D */ { "STA",  AM_ABS_X,     3, 5, OPF_WRITE },
+    /* 9E */ { "STZ",  AM_ABS_X,     3, 5, OPF_WRITE },
+    /* 9F */ { "BBS1", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* A0 */ { "LDY",  AM_IMM,       2, 2, 0 },
+    /* A1 */ { "LDA",  AM_ZP_X_IND,  2, 6, 0 },
+    /* A2 */ { "LDX",  AM_IMM,       2, 2, 0 },
+    /* A3 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* A4 */ { "LDY",  AM_ZP,        2, 3, 0 },
+    /* A5 */ { "LDA",  AM_ZP,        2, 3, 0 },
+    /* A6 */ { "LDX",  AM_ZP,        2, 3, 0 },
+    /* A7 */ { "SMB2", AM_ZP,        2, 5, OPF_WRITE },
+    /* A8 */ { "TAY",  AM_IMP,       1, 2, 0 },
+    /* A9 */ { "LDA",  AM_IMM,       2, 2, 0 },
+    /* AA */ { "TAX",  AM_IMP,       1, 2, 0 },
+    /* AB */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* AC */ { "LDY",  AM_ABS,       3, 4, 0 },
+    /* AD */ { "LDA",  AM_ABS,       3, 4, 0 },
+    /* AE */ { "LDX",  AM_ABS,       3, 4, 0 },
+    /* AF */ { "BBS2", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* B0 */ { "BCS",  AM_REL,       2, 2, OPF_BRANCH },
+    /* B1 */ { "LDA",  AM_ZP_IND_Y,  2, 5, OPF_PAGE_PENALTY },
+    /* B2 */ { "LDA",  AM_ZP_IND,    2, 5, 0 },
+    /* B3 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* B4 */ { "LDY",  AM_ZP_X,      2, 4, 0 },
+    /* B5 */ { "LDA",  AM_ZP_X,      2, 4, 0 },
+    /* B6 */ { "LDX",  AM_ZP_Y,      2, 4, 0 },
+    /* B7 */ { "SMB3", AM_ZP,        2, 5, OPF_WRITE },
+    /* B8 */ { "CLV",  AM_IMP,       1, 2, 0 },
+    /* B9 */ { "LDA",  AM_ABS_Y,     3, 4, OPF_PAGE_PENALTY },
+    /* BA */ { "TSX",  AM_IMP,       1, 2, 0 },
+    /* BB */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* BC */ { "LDY",  AM_ABS_X,     3, 4, OPF_PAGE_PENALTY },
+    /* BD */ { "LDA",  AM_ABS_X,     3, 4, OPF_PAGE_PENALTY },
+    /* BE */ { "LDX",  AM_ABS_Y,     3, 4, OPF_PAGE_PENALTY },
+    /* BF */ { "BBS3", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* C0 */ { "CPY",  AM_IMM,       2, 2, 0 },
+    /* C1 */ { "CMP",  AM_ZP_X_IND,  2, 6, 0 },
+    /* C2 */ { "NOP",  AM_IMM,       2, 2, 0 },
+    /* C3 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* C4 */ { "CPY",  AM_ZP,        2, 3, 0 },
+    /* C5 */ { "CMP",  AM_ZP,        2, 3, 0 },
+    /* C6 */ { "DEC",  AM_ZP,        2, 5, OPF_WRITE },
+    /* C7 */ { "SMB4", AM_ZP,        2, 5, OPF_WRITE },
+    /* C8 */ { "INY",  AM_IMP,       1, 2, 0 },
+    /* C9 */ { "CMP",  AM_IMM,       2, 2, 0 },
+    /* CA */ { "DEX",  AM_IMP,       1, 2, 0 },
+    /* CB */ { "WAI",  AM_IMP,       1, 3, OPF_HALT },
+    /* CC */ { "CPY",  AM_ABS,       3, 4, 0 },
+    /* CD */ { "CMP",  AM_ABS,       3, 4, 0 },
+    /* CE */ { "DEC",  AM_ABS,       3, 6, OPF_WRITE },
+    /* CF */ { "BBS4", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* D0 */ { "BNE",  AM_REL,       2, 2, OPF_BRANCH },
+    /* D1 */ { "CMP",  AM_ZP_IND_Y,  2, 5, OPF_PAGE_PENALTY },
+    /* D2 */ { "CMP",  AM_ZP_IND,    2, 5, 0 },
+    /* D3 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* D4 */ { "NOP",  AM_ZP_X,      2, 4, 0 },
+    /* D5 */ { "CMP",  AM_ZP_X,      2, 4, 0 },
+    /* D6 */ { "DEC",  AM_ZP_X,      2, 6, OPF_WRITE },
+    /* D7 */ { "SMB5", AM_ZP,        2, 5, OPF_WRITE },
+    /* D8 */ { "CLD",  AM_IMP,       1, 2, 0 },
+    /* D9 */ { "CMP",  AM_ABS_Y,     3, 4, OPF_PAGE_PENALTY },
+    /* DA */ { "PHX",  AM_IMP,       1, 3, OPF_STACK },
+    /* DB */ { "STP",  AM_IMP,       1, 3, OPF_HALT },
+    /* DC */ { "NOP",  AM_ABS,       3, 4, 0 },
+    /* DD */ { "CMP",  AM_ABS_X,     3, 4, OPF_PAGE_PENALTY },
+    /* DE */ { "DEC",  AM_ABS_X,     3, 7, OPF_WRITE },
+    /* DF */ { "BBS5", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* E0 */ { "CPX",  AM_IMM,       2, 2, 0 },
+    /* E1 */ { "SBC",  AM_ZP_X_IND,  2, 6, 0 },
+    /* E2 */ { "NOP",  AM_IMM,       2, 2, 0 },
+    /* E3 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* E4 */ { "CPX",  AM_ZP,        2, 3, 0 },
+    /* E5 */ { "SBC",  AM_ZP,        2, 3, 0 },
+    /* E6 */ { "INC",  AM_ZP,        2, 5, OPF_WRITE },
+    /* E7 */ { "SMB6", AM_ZP,        2, 5, OPF_WRITE },
+    /* E8 */ { "INX",  AM_IMP,       1, 2, 0 },
+    /* E9 */ { "SBC",  AM_IMM,       2, 2, 0 },
+    /* EA */ { "NOP",  AM_IMP,       1, 2, 0 },
+    /* EB */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* EC */ { "CPX",  AM_ABS,       3, 4, 0 },
+    /* ED */ { "SBC",  AM_ABS,       3, 4, 0 },
+    /* EE */ { "INC",  AM_ABS,       3, 6, OPF_WRITE },
+    /* EF */ { "BBS6", AM_ZP_REL,    3, 5, OPF_BRANCH },
+    /* F0 */ { "BEQ",  AM_REL,       2, 2, OPF_BRANCH },
+    /* F1 */ { "SBC",  AM_ZP_IND_Y,  2, 5, OPF_PAGE_PENALTY },
+    /* F2 */ { "SBC",  AM_ZP_IND,    2, 5, 0 },
+    /* F3 */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* F4 */ { "NOP",  AM_ZP_X,      2, 4, 0 },
+    /* F5 */ { "SBC",  AM_ZP_X,      2, 4, 0 },
+    /* F6 */ { "INC",  AM_ZP_X,      2, 6, OPF_WRITE },
+    /* F7 */ { "SMB7", AM_ZP,        2, 5, OPF_WRITE },
+    /* F8 */ { "SED",  AM_IMP,       1, 2, 0 },
+    /* F9 */ { "SBC",  AM_ABS_Y,     3, 4, OPF_PAGE_PENALTY },
+    /* FA */ { "PLX",  AM_IMP,       1, 4, OPF_STACK },
+    /* FB */ { "NOP",  AM_IMP,       1, 1, 0 },
+    /* FC */ { "NOP",  AM_ABS,       3, 4, 0 },
+    /* FD */ { "SBC",  AM_ABS_X,     3, 4, OPF_PAGE_PENALTY },
+    /* FE */ { "INC",  AM_ABS_X,     3, 7, OPF_WRITE },
+    /* FF */ { "BBS7", AM_ZP_REL,    3, 5, OPF_BRANCH },
+};
+
+// Length of an instruction in each addressing mode.
+constexpr uint8_t addrModeLength(AddrMode mode) {
+    // every mode from AM_ABS onwards (including AM_ZP_REL) is 3 bytes long.
+    return (mode == AM_IMP || mode == AM_ACC) ? 1 :
+           (mode >= AM_ABS) ? 3 : 2;
+}
+
+constexpr bool opcodeTableConsistent() {
+    for (int i = 0; i < 256; i++) {
+        if (opcodeTable[i].length != addrModeLength(opcodeTable[i].mode)) return false;
+    }
+    return true;
+}
+static_assert(opcodeTableConsistent(), "opcodeTable length does not match its addressing mode");
+
+// A few spot checks that the table agrees with opcodes.h.
+static_assert(opcodeTable[OP_LDA_IMM].mode == AM_IMM, "opcodeTable disagrees with opcodes.h");
+static_assert(opcodeTable[OP_JMP_ABS_X_IND].mode == AM_ABS_X_IND, "opcodeTable disagrees with opcodes.h");
+static_assert(opcodeTable[OP_BBS7].mode == AM_ZP_REL, "opcodeTable disagrees with opcodes.h");
+static_assert(opcodeTable[OP_UNDEF_5C].length == 3, "opcodeTable disagrees with opcodes.h");
+static_assert(opcodeTable[OP_INC_ABS].flags & OPF_WRITE, "opcodeTable disagrees with opcodes.h");
+static_assert(!(opcodeTable[OP_INC_ACC].flags & OPF_WRITE), "opcodeTable disagrees with opcodes.h");
+
+#endif // ifndef OPCODE_TABLE_H
@@ -48,6 +48,7 @@
 #define OP_CMP_IMM      0xC9 /* I */
 #define OP_CMP_ABS      0xCD /* I */
 #define OP_CMP_ZP       0xC5 /* I */
+#define OP_CMP_ZP_IND   0xD2 /* I */
 #define OP_CMP_ABS_X    0xDD /* I */
 #define OP_CMP_ABS_Y    0xD9 /* I */
 #define OP_CMP_ZP_X     0xD5 /* I */
@@ -195,10 +196,10 @@
 #define OP_STZ_ZP_X     0x74 /* IN */
 
 // Test and Set/Reset Bits
-#define OP_TRB_ZP       0x04 /* I */
-#define OP_TRB_ABS      0x0C /* I */
-#define OP_TSB_ZP       0x14 /* I */
-#define OP_TSB_ABS      0x1C /* I */
+#define OP_TSB_ZP       0x04 /* I */
+#define OP_TSB_ABS      0x0C /* I */
+#define OP_TRB_ZP       0x14 /* I */
+#define OP_TRB_ABS      0x1C /* I */
 
 // Branch instructions
 #define OP_BPL          0x10 /* I */
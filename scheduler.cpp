@@ -0,0 +1,102 @@
+// scheduler.cpp - device events, timestamped in processor clock cycles.
+
+#include "scheduler.h"
+
+ScheduledEvent eventQueue[MAX_EVENTS];
+int eventCount = 0;
+uint64_t nextEventCycle = UINT64_MAX;
+
+static uint32_t nextSequence = 0;
+
+static bool earlier(const ScheduledEvent &a, const ScheduledEvent &b) {
+    if (a.cycle != b.cycle) return a.cycle < b.cycle;
+    // sequence numbers wrap, so compare the difference
+    return (int32_t)(a.sequence - b.sequence) < 0;
+}
+
+static void swapEvents(int a, int b) {
+    ScheduledEvent temp = eventQueue[a];
+    eventQueue[a] = eventQueue[b];
+    eventQueue[b] = temp;
+}
+
+static void siftUp(int index) {
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!earlier(eventQueue[index], eventQueue[parent])) break;
+        swapEvents(index, parent);
+        index = parent;
+    }
+}
+
+static void siftDown(int index) {
+    while (true) {
+        int smallest = index;
+        int left = index * 2 + 1;
+        int right = left + 1;
+        if (left < eventCount && earlier(eventQueue[left], eventQueue[smallest])) {
+            smallest = left;
+        }
+        if (right < eventCount && earlier(eventQueue[right], eventQueue[smallest])) {
+            smallest = right;
+        }
+        if (smallest == index) break;
+        swapEvents(index, smallest);
+        index = smallest;
+    }
+}
+
+// Takes the earliest event out of the heap.
+static void removeFirst() {
+    eventQueue[0] = eventQueue[--eventCount];
+    siftDown(0);
+}
+
+static void updateNextEvent() {
+    nextEventCycle = (eventCount > 0) ? eventQueue[0].cycle : UINT64_MAX;
+}
+
+bool scheduleEvent(uint64_t cycle, EventCallback callback, void *context) {
+    if (eventCount == MAX_EVENTS) return false;
+    ScheduledEvent &event = eventQueue[eventCount];
+    event.cycle = cycle;
+    event.sequence = nextSequence++;
+    event.callback = callback;
+    event.context = context;
+    siftUp(eventCount++);
+    updateNextEvent();
+    return true;
+}
+
+int cancelEvents(EventCallback callback, void *context) {
+    int kept = 0;
+    for (int i = 0; i < eventCount; i++) {
+        if (eventQueue[i].callback != callback || eventQueue[i].context != context) {
+            eventQueue[kept++] = eventQueue[i];
+        }
+    }
+    int removed = eventCount - kept;
+    if (removed != 0) {
+        // put what's left back into heap order
+        eventCount = kept;
+        for (int i = eventCount / 2 - 1; i >= 0; i--) {
+            siftDown(i);
+        }
+        updateNextEvent();
+    }
+    return removed;
+}
+
+void clearEvents() {
+    eventCount = 0;
+    updateNextEvent();
+}
+
+void runDueEvents(uint64_t now) {
+    while (eventCount > 0 && eventQueue[0].cycle <= now) {
+        ScheduledEvent event = eventQueue[0];
+        removeFirst();
+        updateNextEvent();
+        event.callback(event.context, event.cycle);
+    }
+}
@@ -0,0 +1,54 @@
+// scheduler.h - device events, timestamped in processor clock cycles.
+// Devices that need to do something at a particular time, such as a timer
+//  running out or a byte arriving at a UART, schedule an event for that cycle
+//  rather than being polled by the host between instructions. The run loop
+//  runs straight through to the earliest event, and calls it as soon as
+//  cycleCount reaches its cycle, between instructions.
+// The events are kept in a fixed-size binary heap, ordered by cycle. Events
+//  due on the same cycle are called in the order they were scheduled.
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAX_EVENTS 64
+
+// Called when an event comes due. due is the cycle it was scheduled for;
+//  cycleCount may already be slightly past it, since the instruction running
+//  at the time is always finished first.
+typedef void (*EventCallback)(void *context, uint64_t due);
+
+struct ScheduledEvent {
+    uint64_t cycle;
+    uint32_t sequence;  // breaks ties between events due on the same cycle
+    EventCallback callback;
+    void *context;
+};
+
+extern ScheduledEvent eventQueue[MAX_EVENTS];
+extern int eventCount;
+
+// The cycle the earliest event is due on, or UINT64_MAX if there are none.
+//  The run loop compares cycleCount against this after every instruction.
+extern uint64_t nextEventCycle;
+
+// Schedules callback to be called with context once cycleCount reaches
+//  cycle. Returns false if the queue is full.
+// May be called from inside an event callback, or from a device being read
+//  or written by the processor.
+bool scheduleEvent(uint64_t cycle, EventCallback callback, void *context);
+
+// Removes every scheduled event with the given callback and context.
+//  Returns the number removed.
+int cancelEvents(EventCallback callback, void *context);
+
+// Removes all scheduled events.
+void clearEvents();
+
+// Calls, and removes, every event due on or before now, earliest first. This
+//  includes any that the callbacks themselves schedule for on or before now.
+void runDueEvents(uint64_t now);
+
+#endif // ifndef SCHEDULER_H
@@ -23,6 +23,10 @@
 
 #include "simulieren-6502.h"
 #include "opcodes.h"
+#include "opcode-table.h"
+#include "breakpoints.h"
+#include "memory-map.h"
+#include "scheduler.h"
 
 #include <stdio.h>
 
@@ -51,20 +55,55 @@ bool flagCarry;     // Indicates carry out of an addition or borrow out of a sub
 
 // Set when a WAI instruction is executed, cleared when an IRQ, NMI, or reset
 //  hits.
+// This and hitSTP are only touched by the thread running the processor. Other
+//  threads wake it through pendingSignals and the wake handler instead.
 bool hitWAI = false;
 
 // Set when a STP instruction is executed, cleared when a reset occurs.
 bool hitSTP = false;
 
-// Set when an IRQ is registered using raiseIRQ(), or by a BRK instruction,
-//  cleared when lowerIRQ() is called.
+// Everything that other threads can signal to the processor, in one word, so
+//  that the run loop can check all of it with a single relaxed load:
+//  bits 0-23   one bit for each source asserting the IRQ line, set by
+//               assertIRQ() and cleared by deassertIRQ(). The line is
+//               asserted while any of these are set.
+//  bit 24      an NMI has been raised, and not yet serviced.
+//  bit 25      requestStop6502() has been called. The reason is in stopReason.
+// Only ever accessed with the __atomic builtins. Setting a bit is a release,
+//  so anything the signalling thread wrote beforehand is visible to the
+//  processor once it has seen the bit and acquired it.
 // NOT CLEARED BY RESET!
-bool IRQraised = false;
+uint32_t pendingSignals = 0;
+#define SIGNAL_IRQ_MASK     0x00FFFFFF
+#define SIGNAL_NMI          0x01000000
+#define SIGNAL_STOP         0x02000000
 
-// Set when an NMI is raised using raiseNMI(), cleared when the the NMI is
-//  serviced.
-// NOT CLEARED BY RESET!
-bool NMIraised = false;
+// The names of the sources allocated by registerIRQSource6502(). Bit 0 is the
+//  host's.
+const char *irqSourceNames[MAX_IRQ_SOURCES] = { "host" };
+
+// Called when something happens that could get the processor out of WAI or
+//  STP. Set with setWakeHandler6502().
+void (*wakeHandler)() = NULL;
+
+// Set by requestStop6502() before it sets SIGNAL_STOP, and returned by
+//  run6502().
+uint8_t stopReason = STOP_COUNT;
+
+// The number of clock cycles executed since power-on.
+uint64_t cycleCount = 0;
+
+// The longest loop, in bytes, that the run loop will try to skip through.
+#define SPIN_MAX_BODY 16
+
+// Set by branch() when it takes a short backward branch, which might be the
+//  end of a polling loop, to the address just after the branch. Checked and
+//  cleared by the run loop. 0 if there wasn't one.
+uint16_t backwardBranch = 0;
+
+// Set by the indexed addressing mode resolvers when indexing carries into the
+//  high byte of the address, which costs some instructions an extra cycle.
+bool pageCrossed;
 
 
 /**************************
@@ -128,7 +167,7 @@ void pullStatus() {
     if ((temp & 0x40) != 0) flagOverflow = true;
     if ((temp & 0x80) != 0) flagNegative = true;
 }
-void pushStatus() {
+uint8_t statusByte() {
     uint8_t temp = 0;
     
     if (flagNegative) temp += MASK_FLAG_NEGATIVE;
@@ -142,30 +181,67 @@ void pushStatus() {
     if (flagZero) temp += MASK_FLAG_ZERO;
     if (flagCarry) temp += MASK_FLAG_CARRY;
     
-    pushByte(temp);
+    return temp;
+}
+void pushStatus() {
+    pushByte(statusByte());
 }
 
 
 /**********************
  * Interface routines *
  **********************/
+uint32_t registerIRQSource6502(const char *name) {
+    for (int i = 0; i < MAX_IRQ_SOURCES; i++) {
+        const char *expected = NULL;
+        if (__atomic_compare_exchange_n(&irqSourceNames[i], &expected, name, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            return 1u << i;
+        }
+    }
+    return 0;
+}
+
+const char *irqSourceName6502(uint32_t source) {
+    for (int i = 0; i < MAX_IRQ_SOURCES; i++) {
+        if (source == (1u << i)) return __atomic_load_n(&irqSourceNames[i], __ATOMIC_ACQUIRE);
+    }
+    return NULL;
+}
+
+uint32_t irqSources6502() {
+    return __atomic_load_n(&pendingSignals, __ATOMIC_RELAXED) & SIGNAL_IRQ_MASK;
+}
+
+void assertIRQ(uint32_t sources) {
+    sources &= SIGNAL_IRQ_MASK;
+    if (sources == 0) return;
+    __atomic_fetch_or(&pendingSignals, sources, __ATOMIC_RELEASE);
+    if (wakeHandler != NULL) wakeHandler();
+}
+
+void deassertIRQ(uint32_t sources) {
+    __atomic_fetch_and(&pendingSignals, ~(sources & SIGNAL_IRQ_MASK), __ATOMIC_RELEASE);
+}
+
 // This function indicates to the emulated processor that an interrupt is
 //  awaiting service.
 void raiseIRQ() {
-    IRQraised = true;
+    assertIRQ(IRQ_SOURCE_HOST);
 }
 
-// This function indicates to the emulated processor that no interrupts are
-//  awaiting service.
+// This function indicates to the emulated processor that the host's interrupt
+//  is no longer awaiting service.
 void lowerIRQ() {
-    IRQraised = false;
+    deassertIRQ(IRQ_SOURCE_HOST);
 }
 
 // This function indicates to the emulated processor that a non-maskable
 //  interrupt has occurred. There is no lowerNMI() because on a real 65c02, the
 //  NMI input is active-edge-sensitive.
 void raiseNMI() {
-    NMIraised = true;
+    __atomic_fetch_or(&pendingSignals, SIGNAL_NMI, __ATOMIC_RELEASE);
+    if (wakeHandler != NULL) wakeHandler();
 }
 
 // Sets the Overflow(V) flag, in much the same way the /SO (Set Overflow) pin on
@@ -174,6 +250,18 @@ void setOverflow() {
     flagOverflow = true;
 }
 
+// Makes run6502() return once the current instruction has finished.
+void requestStop6502(uint8_t reason) {
+    __atomic_store_n(&stopReason, reason, __ATOMIC_RELAXED);
+    __atomic_fetch_or(&pendingSignals, SIGNAL_STOP, __ATOMIC_RELEASE);
+}
+
+// Sets the function called whenever the processor may need to come out of WAI
+//  or STP.
+void setWakeHandler6502(void (*handler)()) {
+    wakeHandler = handler;
+}
+
 
 /**********************
  * Emulation routines *
@@ -212,6 +300,7 @@ void reset6502(bool faithful) {
     // the effects of STP and WAI are ended by a reset.
     hitSTP = false;
     hitWAI = false;
+    if (wakeHandler != NULL) wakeHandler();
 }
 
 void doInterrupt(uint16_t vector) {
@@ -224,10 +313,20 @@ void doInterrupt(uint16_t vector) {
 }
 
 void branch(int8_t displacement) {
-    programCounter += displacement;
+    uint16_t target = programCounter + displacement;
+    // a branch to another page takes an extra cycle
+    if ((target ^ programCounter) & 0xFF00) {
+        cycleCount++;
+    }
+    if (target < programCounter && programCounter - target <= SPIN_MAX_BODY) {
+        backwardBranch = programCounter;
+    }
+    programCounter = target;
 }
 void branchIf(bool flag) {
     if (flag) {
+        // a taken branch takes an extra cycle
+        cycleCount++;
         branch((int8_t) readByte(programCounter++));
     } else {
         programCounter++;
@@ -241,10 +340,14 @@ uint16_t getABSAddr() {
     return ret;
 }
 uint16_t getABS_XAddr() {
-    return getABSAddr() + X;
+    uint16_t base = getABSAddr();
+    pageCrossed = ((base & 0xFF) + X) > 0xFF;
+    return base + X;
 }
 uint16_t getABS_YAddr() {
-    return getABSAddr() + Y;
+    uint16_t base = getABSAddr();
+    pageCrossed = ((base & 0xFF) + Y) > 0xFF;
+    return base + Y;
 }
 uint16_t getABS_INDAddr() {
     uint16_t addrSrc = getABSAddr();
@@ -274,7 +377,9 @@ uint16_t getZP_X_INDAddr() {
     return readShort(addrSrc);
 }
 uint16_t getZP_IND_YAddr() {
-    return getZP_INDAddr() + Y;
+    uint16_t base = getZP_INDAddr();
+    pageCrossed = ((base & 0xFF) + Y) > 0xFF;
+    return base + Y;
 }
 
 void adc(uint8_t value) {
@@ -287,6 +392,8 @@ void adc(uint8_t value) {
         flagCarry = (intermediateResult > 0xFF) ? true : false;
         A = (uint8_t)intermediateResult;
     } else {
+        // decimal mode takes an extra cycle on the 65C02
+        cycleCount++;
             //printf("decimal mode adc:\n");
         //decimal mode
         // add low nybble
@@ -328,6 +435,8 @@ void sbc(uint8_t value) {
     if (!flagDecimal) {
         adc(~value);
     } else {
+        // decimal mode takes an extra cycle on the 65C02
+        cycleCount++;
         
             //printf("decimal sbc: %02X - %02X. C = %i\n", A, value, flagCarry);
         // I do not understand this properly...
@@ -483,6 +592,7 @@ void smb(int bit) {
 void bbs(int bit) {
     uint8_t data = readByte(getZPAddr()) & (0x01 << bit);
     if (data != 0) {
+        cycleCount++;
         branch(readByte(programCounter++));
     } else {
         programCounter++;
@@ -491,6 +601,7 @@ void bbs(int bit) {
 void bbr(int bit) {
     uint8_t data = readByte(getZPAddr()) & (0x01 << bit);
     if (data == 0) {
+        cycleCount++;
         branch(readByte(programCounter++));
     } else {
         programCounter++;
@@ -514,6 +625,28 @@ void ldy(uint8_t value) {
 }
 // Register stores are implemented directly.
 
+// Starts servicing an NMI or IRQ, if there is one waiting that isn't masked.
+void serviceInterrupts() {
+    // the usual case, with nothing waiting, is one relaxed load
+    uint32_t pending = __atomic_load_n(&pendingSignals, __ATOMIC_RELAXED);
+    if (!(pending & (SIGNAL_NMI | SIGNAL_IRQ_MASK))) return;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    
+    if (pending & SIGNAL_NMI) {
+        // process NMI
+        __atomic_fetch_and(&pendingSignals, ~SIGNAL_NMI, __ATOMIC_RELAXED);
+        doInterrupt(NMI_VEC);
+        cycleCount += 7;
+      //printf("PC changed by NMI to %04X\n", programCounter);
+    } else if ((pending & SIGNAL_IRQ_MASK) && !flagIRQdisable) {
+        // process IRQ
+        // BRK is handled seperatedly, bypassing this handler.
+        doInterrupt(IRQ_VEC);
+        cycleCount += 7;
+      //printf("PC changed by IRQ to %04X\n", programCounter);
+    }
+}
+
 // Processes a single 6502 instruction.
 void do6502() {
     // Deal with the special case first:
@@ -525,9 +658,29 @@ void do6502() {
     // If a STP has previously been executed, do nothing.
     //  IRQ and NMI have no effect on STP.
     if (hitSTP) return;
-        
+    
+    // If a WAI has previously been executed, do nothing until an IRQ or NMI
+    //  comes along. An interrupt that can be serviced is serviced straight
+    //  away. A masked IRQ ends the WAI, and execution carries on with the next
+    //  instruction.
+    if (hitWAI) {
+        uint32_t pending = __atomic_load_n(&pendingSignals, __ATOMIC_RELAXED);
+        if (!(pending & (SIGNAL_NMI | SIGNAL_IRQ_MASK))) return;
+        hitWAI = false;
+        if ((pending & SIGNAL_NMI) || !flagIRQdisable) {
+            serviceInterrupts();
+            return;
+        }
+    }
+    
     uint8_t opcode = readByte(programCounter++); // move PC to the byte after the instruction
     
+    // Taken branches, decimal mode, and page crossings add their own extra
+    //  cycles as they happen.
+    const OpcodeInfo &info = opcodeTable[opcode];
+    cycleCount += info.cycles;
+    pageCrossed = false;
+    
     switch (opcode) {
         // Control instructions
         case OP_BRK:
@@ -627,21 +780,165 @@ void do6502() {
         #include "undefined.h"
     }
     
-    if (NMIraised) {
-        // process NMI
-        NMIraised = false;
-        doInterrupt(NMI_VEC);
-      //printf("PC changed by NMI to %04X\n", programCounter);
-    } else if (IRQraised && !flagIRQdisable) {
-        // process IRQ
-        // BRK is handled seperatedly, bypassing this handler.
-        doInterrupt(IRQ_VEC);
-      //printf("PC changed by IRQ to %04X\n", programCounter);
+    if (pageCrossed && (info.flags & OPF_PAGE_PENALTY)) {
+        cycleCount++;
     }
     
-    // If we are currently in a WAI instruction, and neither an IRQ or an NMI
-    //  have occurred, do nothing. (Hitting an IRQ or NMI will clear this)
-    if (hitWAI) {
+    serviceInterrupts();
+}
+
+/*************************
+ * Spin-loop fast-forward *
+ *************************/
+// Guest code often sits in a short loop polling a device, such as
+//  LDA status / AND #mask / BEQ loop. If the loop only reads, and the
+//  registers and flags are exactly the same each time round, then the only
+//  thing that can get it out is the device changing. That only happens when
+//  the host gets control back or the next scheduled event comes due, so the
+//  iterations up to then can be skipped, and just their cycles counted.
+// A loop is only considered if its body is straight-line code, ending in the
+//  branch back, with nothing in it that writes memory, touches the stack,
+//  jumps, or halts, and no breakpoints in it.
+
+struct SpinLoop {
+    uint16_t head;          // target of the backward branch
+    uint16_t tail;          // address just after the branch
+    bool checked;           // set once the body has been looked at
+    bool suitable;          // set if the body can be skipped
+    uint32_t length;        // in instructions
+    // state at the head, the last time round
+    uint8_t A, X, Y, stackPointer, status;
+    uint64_t cycles;
+    uint32_t count;         // instructions left to the run loop
+};
+
+static SpinLoop spin;
+
+static uint8_t peekByte(uint16_t address) {
+    if (activeMap != NULL) return mapPeek(activeMap, address);
+    return readByte(address);
+}
+
+// Looks at the body of the loop in spin, to see if it can be skipped.
+static void checkSpinBody() {
+    spin.checked = true;
+    spin.suitable = false;
+    spin.length = 0;
+    uint16_t address = spin.head;
+    while (address < spin.tail) {
+        const OpcodeInfo &info = opcodeTable[peekByte(address)];
+        bool last = (address + info.length == spin.tail);
+        if (breakpointAt(address)) return;
+        if (info.flags & (OPF_WRITE | OPF_STACK | OPF_JUMP | OPF_HALT)) return;
+        if ((info.flags & OPF_BRANCH) && !last) return;
+        address += info.length;
+        spin.length++;
+    }
+    spin.suitable = (address == spin.tail);
+}
+
+static void snapshotSpin(uint32_t count) {
+    spin.A = A;
+    spin.X = X;
+    spin.Y = Y;
+    spin.stackPointer = stackPointer;
+    spin.status = statusByte();
+    spin.cycles = cycleCount;
+    spin.count = count;
+}
+
+// Called by the run loop after a short backward branch has been taken, with
+//  the number of instructions it has left to run. Skips as many whole
+//  iterations as fit before count runs out or cycleCount reaches deadline.
+static void fastForwardSpin(uint32_t &count, uint64_t deadline, uint16_t tail) {
+    if (spin.head != programCounter || spin.tail != tail) {
+        // a different loop
+        spin.head = programCounter;
+        spin.tail = tail;
+        spin.checked = false;
+        snapshotSpin(count);
+        return;
+    }
+    if (!spin.checked) checkSpinBody();
+    if (!spin.suitable) return;
+    
+    // An interrupt in the middle of an iteration shows up as the wrong number
+    //  of instructions having been run.
+    if (spin.count - count != spin.length || A != spin.A || X != spin.X
+        || Y != spin.Y || stackPointer != spin.stackPointer
+        || statusByte() != spin.status) {
+        snapshotSpin(count);
         return;
     }
+    
+    uint64_t period = cycleCount - spin.cycles;
+    uint64_t iterations = count / spin.length;
+    if (deadline != UINT64_MAX && (deadline - cycleCount) / period < iterations) {
+        iterations = (deadline - cycleCount) / period;
+    }
+    cycleCount += iterations * period;
+    count -= iterations * spin.length;
+    snapshotSpin(count);
+}
+
+// Processes instructions until count have been executed, or cycleCount reaches
+//  deadline, whichever comes first. Stops early at breakpoints or when
+//  requested.
+static uint8_t runLoop(uint32_t count, uint64_t deadline) {
+    // breakpoints may have changed since last time
+    spin.checked = false;
+    backwardBranch = 0;
+    runDueEvents(cycleCount);
+    while (count > 0 && cycleCount < deadline) {
+        if (hitSTP || (hitWAI && !(__atomic_load_n(&pendingSignals, __ATOMIC_RELAXED)
+                                   & (SIGNAL_NMI | SIGNAL_IRQ_MASK)))) {
+            // Nothing will happen until an event raises an interrupt, or a
+            //  reset, but time still passes. Each event fired counts as an
+            //  instruction, so that run6502() still returns.
+            if (nextEventCycle < deadline) {
+                cycleCount = nextEventCycle;
+                runDueEvents(cycleCount);
+                count--;
+                continue;
+            }
+            if (deadline != UINT64_MAX) {
+                cycleCount = deadline;
+            }
+            return STOP_IDLE;
+        }
+        do6502();
+        count--;
+        
+        // devices are only looked at when one of them has something to do
+        if (cycleCount >= nextEventCycle) {
+            runDueEvents(cycleCount);
+        }
+        if (__atomic_load_n(&pendingSignals, __ATOMIC_RELAXED) & SIGNAL_STOP) {
+            __atomic_fetch_and(&pendingSignals, ~SIGNAL_STOP, __ATOMIC_ACQUIRE);
+            return __atomic_load_n(&stopReason, __ATOMIC_RELAXED);
+        }
+        // one bit test per instruction. The conditions and hit counts are
+        //  only looked at if a breakpoint is actually set here.
+        if (breakpointAt(programCounter) && breakpointHit(programCounter)) {
+            return STOP_BREAKPOINT;
+        }
+        if (backwardBranch != 0) {
+            fastForwardSpin(count, (nextEventCycle < deadline) ? nextEventCycle : deadline,
+                            backwardBranch);
+            backwardBranch = 0;
+        }
+    }
+    return STOP_COUNT;
+}
+
+// Processes up to count 6502 instructions, stopping early at breakpoints or
+//  when requested.
+uint8_t run6502(uint32_t count) {
+    return runLoop(count, UINT64_MAX);
+}
+
+// Processes instructions until at least cycles clock cycles have passed,
+//  stopping early at breakpoints or when requested.
+uint8_t runCycles6502(uint32_t cycles) {
+    return runLoop(UINT32_MAX, cycleCount + cycles);
 }
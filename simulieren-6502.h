@@ -20,14 +20,74 @@ void reset6502(bool faithful);
 // Processes a single 6502 instruction.
 void do6502();
 
+// Reasons for run6502() returning.
+#define STOP_COUNT      0   // the requested number of instructions were executed
+#define STOP_BREAKPOINT 1   // the program counter reached a breakpoint
+#define STOP_WATCHPOINT 2   // a watched memory location was accessed
+#define STOP_REQUESTED  3   // the host called requestStop6502()
+#define STOP_IDLE       4   // the processor is in WAI or STP, and nothing will
+                            //  happen until an interrupt or reset
+
+// Processes up to count 6502 instructions.
+// Stops early, with the program counter pointing at the next instruction to
+//  be executed, if a breakpoint is reached or requestStop6502() is called.
+//  Breakpoints whose conditions aren't met don't cause it to return.
+// Events in scheduler.h are called as they come due, between instructions.
+// Also returns early if the processor is idle in WAI or STP, rather than
+//  spinning. The host can then block until the wake handler is called. While
+//  idle with an event scheduled, it skips straight to the event instead.
+// Returns one of the STOP_ reasons above.
+uint8_t run6502(uint32_t count);
+
+// Processes instructions until at least cycles clock cycles have passed, as
+//  counted by cycleCount. The last instruction may overrun slightly.
+// If the processor is idle in WAI or STP, the time passes without any
+//  instructions being executed, and it returns STOP_IDLE.
+// Stops early in the same way as run6502(), and returns the same reasons.
+uint8_t runCycles6502(uint32_t cycles);
+
+// The functions below that raise or lower interrupts, or request a stop, may be
+//  called from any thread while the processor is running. They are lock-free:
+//  the processor picks them up between instructions with a single relaxed
+//  load, and anything the calling thread wrote beforehand is visible to the
+//  processor by then.
+
+// Makes run6502() return once the current instruction has finished.
+// Memory-mapped devices and watchpoints use this to get the host's attention.
+void requestStop6502(uint8_t reason);
+
+// The IRQ input is wired-OR, as on real hardware: each device that can
+//  interrupt has its own bit, and the line is asserted while any of them are
+//  asserting it. One device letting go of the line doesn't lose another
+//  device's interrupt.
+// Bit 0 belongs to the host, through raiseIRQ() and lowerIRQ(). Devices get
+//  their own bits from registerIRQSource6502().
+#define IRQ_SOURCE_HOST     0x00000001
+#define MAX_IRQ_SOURCES     24
+
+// Allocates an IRQ source bit for a device, and remembers its name for
+//  debugging. Returns 0 if all of them are in use; asserting 0 does nothing.
+uint32_t registerIRQSource6502(const char *name);
+
+// Returns the name a source bit was registered with, or NULL.
+const char *irqSourceName6502(uint32_t source);
+
+// Returns the sources currently asserting the IRQ line.
+uint32_t irqSources6502();
+
+// Asserts or releases the IRQ line on behalf of the given sources.
+// While the line is asserted and interrupts are enabled, the processor will
+//  execute the next instruction, and then begin executing the ISR on the
+//  instruction after that.
+void assertIRQ(uint32_t sources);
+void deassertIRQ(uint32_t sources);
+
 // This function indicates to the simulated processor that an interrupt is
-//  awaiting service.
-// The processor will execute the next instruction, and then begin executing the
-//  ISR on the instruction after that.
+//  awaiting service. Same as assertIRQ(IRQ_SOURCE_HOST).
 void raiseIRQ();
 
-// This function indicates to the simulated processor that no interrupts are
-//  awaiting service.
+// This function indicates to the simulated processor that the host's
+//  interrupt is no longer awaiting service. Other sources are unaffected.
 void lowerIRQ();
 
 // This function indicates to the simulated processor that a non-maskable
@@ -37,6 +97,12 @@ void lowerIRQ();
 //  65c02(as with the IRQ), an NMI is no longer considered to be waiting.
 void raiseNMI();
 
+// Sets a function to be called whenever something happens that could bring
+//  the processor out of WAI or STP: assertIRQ(), raiseNMI(), and reset6502().
+//  A host that blocks while the processor is idle should use this to wake up.
+// It may be called from whichever thread raised the interrupt.
+void setWakeHandler6502(void (*handler)());
+
 // Sets the Overflow(V) flag, in much the same way the /SO (Set Overflow) pin on
 //  real hardware would.
 void setOverflow();
@@ -0,0 +1,52 @@
+// spsc-queue.h - a lock-free queue for passing values from exactly one
+//  producer thread to exactly one consumer thread.
+// The producer only ever writes head, and the consumer only ever writes tail,
+//  so no locking is needed: each side publishes its index with a release
+//  store, and reads the other side's with an acquire load.
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Must be a power of two.
+#define SPSC_QUEUE_SIZE 1024
+
+struct SPSCQueue {
+    uint16_t items[SPSC_QUEUE_SIZE];
+    // kept on separate cache lines so the two threads don't fight over them
+    alignas(64) uint32_t head;  // next slot to write. Written by the producer.
+    alignas(64) uint32_t tail;  // next slot to read. Written by the consumer.
+};
+
+inline void spscInit(SPSCQueue *queue) {
+    queue->head = 0;
+    queue->tail = 0;
+}
+
+// Called by the producer. Returns false if the queue is full.
+inline bool spscPush(SPSCQueue *queue, uint16_t item) {
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (head - tail == SPSC_QUEUE_SIZE) {
+        return false;
+    }
+    queue->items[head & (SPSC_QUEUE_SIZE - 1)] = item;
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Called by the consumer. Returns false if the queue is empty.
+inline bool spscPop(SPSCQueue *queue, uint16_t *item) {
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return false;
+    }
+    *item = queue->items[tail & (SPSC_QUEUE_SIZE - 1)];
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+#endif // ifndef SPSC_QUEUE_H
@@ -33,8 +33,7 @@ extern bool flagCarry;     // Indicates carry out of an addition or borrow out o
 
 extern bool hitWAI;
 extern bool hitSTP;
-extern bool IRQraised;
-extern bool NMIraised;
+extern uint32_t pendingSignals;
 
 // this is the primary purpose of having this module...
 bool logging = false;
@@ -0,0 +1,95 @@
+// throttle.cpp - paces the simulator to a fixed emulated clock frequency.
+
+#include "throttle.h"
+
+#include <time.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+extern uint64_t cycleCount;
+
+static uint64_t nowNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// converts a number of emulated cycles into nanoseconds, without overflowing
+//  for long runs.
+static uint64_t cyclesToNs(const Throttle *throttle, uint64_t cycles) {
+    uint64_t seconds = cycles / throttle->frequency;
+    uint64_t remainder = cycles % throttle->frequency;
+    return seconds * 1000000000 + remainder * 1000000000 / throttle->frequency;
+}
+
+void throttleStart(Throttle *throttle, uint32_t frequency) {
+    throttle->frequency = frequency;
+    throttle->sliceCycles = (uint64_t)frequency * THROTTLE_SLICE_NS / 1000000000;
+    if (throttle->sliceCycles == 0) {
+        throttle->sliceCycles = 1;
+    }
+    throttle->maxLagNs = THROTTLE_MAX_LAG_NS;
+    
+    throttle->slices = 0;
+    throttle->lateSlices = 0;
+    throttle->resyncs = 0;
+    throttle->maxDriftNs = 0;
+    throttle->minDriftNs = 0;
+    throttle->totalAbsDriftNs = 0;
+    throttle->sleptNs = 0;
+    throttle->elapsedNs = 0;
+    
+#ifdef __linux__
+    // The default 50us of timer slack is a large part of a 1ms slice.
+    prctl(PR_SET_TIMERSLACK, 1);
+#endif
+    throttle->startCycles = cycleCount;
+    throttle->startNs = nowNs();
+    throttle->beganNs = throttle->startNs;
+}
+
+void throttleWait(Throttle *throttle) {
+    uint64_t target = throttle->startNs + cyclesToNs(throttle, cycleCount - throttle->startCycles);
+    uint64_t now = nowNs();
+    
+    if (now < target) {
+        struct timespec wake;
+        wake.tv_sec = target / 1000000000;
+        wake.tv_nsec = target % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) != 0);
+        uint64_t woke = nowNs();
+        throttle->sleptNs += woke - now;
+        now = woke;
+    } else {
+        throttle->lateSlices++;
+    }
+    
+    int64_t drift = (int64_t)(now - target);
+    if (drift > throttle->maxLagNs) {
+        // Too far behind to catch up. Write the lost time off by moving the
+        //  start forwards, so the emulated clock lines up with now.
+        throttle->startNs += drift;
+        throttle->resyncs++;
+    }
+    
+    throttle->slices++;
+    if (drift > throttle->maxDriftNs) throttle->maxDriftNs = drift;
+    if (drift < throttle->minDriftNs) throttle->minDriftNs = drift;
+    throttle->totalAbsDriftNs += (drift < 0) ? -drift : drift;
+    throttle->elapsedNs = now - throttle->beganNs;
+}
+
+void throttleReport(const Throttle *throttle, FILE *out) {
+    if (throttle->slices == 0) {
+        return;
+    }
+    fprintf(out, "]Clock %u Hz, %llu slices of %u cycles\n", throttle->frequency,
+            (unsigned long long)throttle->slices, throttle->sliceCycles);
+    fprintf(out, "]Drift: mean %llu us, min %lld us, max %lld us\n",
+            (unsigned long long)(throttle->totalAbsDriftNs / throttle->slices / 1000),
+            (long long)(throttle->minDriftNs / 1000), (long long)(throttle->maxDriftNs / 1000));
+    fprintf(out, "]%llu late slices, %llu resyncs, host asleep %llu%% of the time\n",
+            (unsigned long long)throttle->lateSlices, (unsigned long long)throttle->resyncs,
+            (unsigned long long)(throttle->elapsedNs ? throttle->sleptNs * 100 / throttle->elapsedNs : 0));
+}
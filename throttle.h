@@ -0,0 +1,51 @@
+// throttle.h - paces the simulator to a fixed emulated clock frequency.
+// The host runs the simulator in time slices of a fixed number of cycles.
+//  After each slice, throttleWait() compares how much emulated time has
+//  passed against a monotonic host clock, and sleeps until the host catches
+//  up. If the host falls behind, the next slices run without sleeping until
+//  it has caught up, but it never tries to make up more than maxLag; past
+//  that, the lost time is written off, so a stall on the host doesn't turn
+//  into a burst of flat-out emulation afterwards.
+
+#ifndef THROTTLE_H
+#define THROTTLE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Defaults: 1ms slices, and up to 20ms of catching up.
+#define THROTTLE_SLICE_NS   1000000
+#define THROTTLE_MAX_LAG_NS 20000000
+
+struct Throttle {
+    uint32_t frequency;     // emulated clock, in Hz
+    uint32_t sliceCycles;   // cycles per time slice
+    int64_t maxLagNs;       // how far behind the host may fall before resyncing
+    
+    uint64_t startNs;       // host time that startCycles corresponds to
+    uint64_t startCycles;
+    uint64_t beganNs;       // host time throttleStart() was called
+    
+    // Statistics. Drift is how late the host was for the end of a slice,
+    //  measured after any sleep. Negative drift means it woke up early.
+    uint64_t slices;        // slices completed
+    uint64_t lateSlices;    // slices that ended after their deadline, without sleeping
+    uint64_t resyncs;       // times the host fell more than maxLag behind
+    int64_t maxDriftNs;
+    int64_t minDriftNs;
+    uint64_t totalAbsDriftNs;
+    uint64_t sleptNs;       // total time spent asleep
+    uint64_t elapsedNs;     // total host time since throttleStart()
+};
+
+// Starts pacing to frequency Hz, from the current cycleCount.
+void throttleStart(Throttle *throttle, uint32_t frequency);
+
+// Called after each slice of throttle->sliceCycles cycles. Sleeps until the
+//  host clock reaches the emulated time, and updates the statistics.
+void throttleWait(Throttle *throttle);
+
+// Prints the drift statistics.
+void throttleReport(const Throttle *throttle, FILE *out);
+
+#endif // ifndef THROTTLE_H
@@ -0,0 +1,362 @@
+// w65c22.cpp - a W65C22 VIA (Versatile Interface Adapter) device.
+
+#include "w65c22.h"
+#include "scheduler.h"
+#include "simulieren-6502.h"
+
+extern uint64_t cycleCount;
+
+/***********
+ * Helpers *
+ ***********/
+
+static void updateIRQ(W65C22 *via) {
+    bool asserted = (via->ifr & via->ier & 0x7F) != 0;
+    if (asserted == via->irqAsserted) {
+        return;
+    }
+    via->irqAsserted = asserted;
+    if (asserted) {
+        assertIRQ(via->irqSource);
+    } else {
+        deassertIRQ(via->irqSource);
+    }
+}
+
+static void setFlags(W65C22 *via, uint8_t flags) {
+    via->ifr |= flags;
+    updateIRQ(via);
+}
+
+static void clearFlags(W65C22 *via, uint8_t flags) {
+    via->ifr &= ~flags;
+    updateIRQ(via);
+}
+
+static uint8_t srMode(const W65C22 *via) {
+    return (via->acr & VIA_ACR_SR_MASK) >> VIA_ACR_SR_SHIFT;
+}
+
+static uint16_t t1Counter(const W65C22 *via) {
+    return via->t1Count - (uint16_t)(cycleCount - via->t1Base);
+}
+
+static uint16_t t2Counter(const W65C22 *via) {
+    if (via->acr & VIA_ACR_T2_PULSES) {
+        return via->t2Count;
+    }
+    return via->t2Count - (uint16_t)(cycleCount - via->t2Base);
+}
+
+/**********
+ * Events *
+ **********/
+
+static void t1Event(void *context, uint64_t due) {
+    W65C22 *via = (W65C22 *)context;
+    bool freeRunning = (via->acr & VIA_ACR_T1_FREE) != 0;
+
+    if (via->t1Armed) {
+        if (via->acr & VIA_ACR_T1_PB7) {
+            // PB7 toggles each time in free-running mode, and goes high once
+            //  in one-shot mode.
+            via->pb7 = freeRunning ? !via->pb7 : true;
+        }
+        via->t1Armed = freeRunning;
+        setFlags(via, VIA_INT_T1);
+    }
+    if (freeRunning) {
+        // reload from the latches on the next cycle
+        via->t1Base = due + 1;
+        via->t1Count = via->t1Latch;
+        scheduleEvent(via->t1Base + via->t1Count + 1, t1Event, via);
+    }
+    // in one-shot mode the counter carries on down, without interrupting
+}
+
+static void t2Event(void *context, uint64_t due) {
+    W65C22 *via = (W65C22 *)context;
+    if (via->t2Armed) {
+        via->t2Armed = false;
+        setFlags(via, VIA_INT_T2);
+    }
+}
+
+// How long a whole byte takes to shift in the given mode, or 0 if it is
+//  externally clocked, and so never finishes.
+static uint64_t shiftTime(const W65C22 *via, uint8_t mode) {
+    switch (mode) {
+        case VIA_SR_IN_T2:
+        case VIA_SR_OUT_FREE:
+        case VIA_SR_OUT_T2:
+            // CB1 toggles each time T2's low byte runs out
+            return 8 * 2 * ((uint64_t)via->t2LatchLow + 2);
+        case VIA_SR_IN_PHI2:
+        case VIA_SR_OUT_PHI2:
+            return 8 * 2;
+    }
+    return 0;
+}
+
+static void srEvent(void *context, uint64_t due) {
+    W65C22 *via = (W65C22 *)context;
+    uint8_t mode = srMode(via);
+
+    if (mode & 0x04) {
+        if (via->shiftOut != NULL) via->shiftOut(via->context, via->sr);
+    } else {
+        via->sr = (via->shiftIn != NULL) ? via->shiftIn(via->context) : 0xFF;
+    }
+
+    if (mode == VIA_SR_OUT_FREE) {
+        // keep going, without interrupting
+        scheduleEvent(due + shiftTime(via, mode), srEvent, via);
+        return;
+    }
+    via->shifting = false;
+    setFlags(via, VIA_INT_SR);
+}
+
+// Starts shifting a byte, as a read or write of SR does.
+static void startShift(W65C22 *via) {
+    uint8_t mode = srMode(via);
+    clearFlags(via, VIA_INT_SR);
+    cancelEvents(srEvent, via);
+    via->shifting = false;
+
+    uint64_t time = shiftTime(via, mode);
+    if (time != 0) {
+        via->shifting = true;
+        scheduleEvent(cycleCount + time, srEvent, via);
+    }
+}
+
+/*************
+ * Registers *
+ *************/
+
+// Works out what reading a register would return, without side effects.
+static uint8_t viaRegister(const W65C22 *via, uint8_t reg) {
+    switch (reg) {
+        case VIA_ORB: {
+            uint8_t value = (via->orb & via->ddrb) | (via->portBPins & ~via->ddrb);
+            if (via->acr & VIA_ACR_T1_PB7) {
+                value = (value & 0x7F) | (via->pb7 ? 0x80 : 0);
+            }
+            return value;
+        }
+        case VIA_ORA:
+        case VIA_ORA_NH:
+            return (via->ora & via->ddra) | (via->portAPins & ~via->ddra);
+        case VIA_DDRB:  return via->ddrb;
+        case VIA_DDRA:  return via->ddra;
+        case VIA_T1CL:  return t1Counter(via) & 0xFF;
+        case VIA_T1CH:  return t1Counter(via) >> 8;
+        case VIA_T1LL:  return via->t1Latch & 0xFF;
+        case VIA_T1LH:  return via->t1Latch >> 8;
+        case VIA_T2CL:  return t2Counter(via) & 0xFF;
+        case VIA_T2CH:  return t2Counter(via) >> 8;
+        case VIA_SR:    return via->sr;
+        case VIA_ACR:   return via->acr;
+        case VIA_PCR:   return via->pcr;
+        case VIA_IFR:
+            return via->ifr | ((via->ifr & via->ier & 0x7F) ? VIA_INT_ANY : 0);
+        case VIA_IER:   return via->ier | 0x80;
+    }
+    return 0x00;
+}
+
+static uint8_t viaPeek(void *context, uint16_t address) {
+    W65C22 *via = (W65C22 *)context;
+    return viaRegister(via, (address - via->device.start) & 0x0F);
+}
+
+static uint8_t viaRead(void *context, uint16_t address) {
+    W65C22 *via = (W65C22 *)context;
+    uint8_t reg = (address - via->device.start) & 0x0F;
+    uint8_t value = viaRegister(via, reg);
+
+    switch (reg) {
+        case VIA_ORB:
+            clearFlags(via, VIA_INT_CB1 | VIA_INT_CB2);
+            break;
+        case VIA_ORA:
+            clearFlags(via, VIA_INT_CA1 | VIA_INT_CA2);
+            break;
+        case VIA_T1CL:
+            clearFlags(via, VIA_INT_T1);
+            break;
+        case VIA_T2CL:
+            clearFlags(via, VIA_INT_T2);
+            break;
+        case VIA_SR:
+            startShift(via);
+            break;
+    }
+    return value;
+}
+
+static void writeACR(W65C22 *via, uint8_t data) {
+    uint8_t changed = via->acr ^ data;
+
+    if (changed & VIA_ACR_T2_PULSES) {
+        // freeze or restart T2's counter where it is
+        via->t2Count = t2Counter(via);
+        via->t2Base = cycleCount;
+        cancelEvents(t2Event, via);
+        if (!(data & VIA_ACR_T2_PULSES) && via->t2Armed) {
+            scheduleEvent(via->t2Base + via->t2Count + 1, t2Event, via);
+        }
+    }
+    via->acr = data;
+
+    if ((changed & VIA_ACR_SR_MASK) && via->shifting && shiftTime(via, srMode(via)) == 0) {
+        // shifting stops if the shift register is turned off or switched to an
+        //  external clock
+        cancelEvents(srEvent, via);
+        via->shifting = false;
+    }
+}
+
+static void viaWrite(void *context, uint16_t address, uint8_t data) {
+    W65C22 *via = (W65C22 *)context;
+
+    switch ((address - via->device.start) & 0x0F) {
+        case VIA_ORB:
+            via->orb = data;
+            clearFlags(via, VIA_INT_CB1 | VIA_INT_CB2);
+            if (via->portWrite != NULL) via->portWrite(via->context, VIA_ORB, via->orb);
+            break;
+        case VIA_ORA:
+            clearFlags(via, VIA_INT_CA1 | VIA_INT_CA2);
+            // fall through
+        case VIA_ORA_NH:
+            via->ora = data;
+            if (via->portWrite != NULL) via->portWrite(via->context, VIA_ORA, via->ora);
+            break;
+        case VIA_DDRB:
+            via->ddrb = data;
+            if (via->portWrite != NULL) via->portWrite(via->context, VIA_ORB, via->orb);
+            break;
+        case VIA_DDRA:
+            via->ddra = data;
+            if (via->portWrite != NULL) via->portWrite(via->context, VIA_ORA, via->ora);
+            break;
+        case VIA_T1CL:
+        case VIA_T1LL:
+            via->t1Latch = (via->t1Latch & 0xFF00) | data;
+            break;
+        case VIA_T1CH:
+            // load the counter from the latches, and start counting
+            via->t1Latch = (via->t1Latch & 0x00FF) | (data << 8);
+            via->t1Count = via->t1Latch;
+            via->t1Base = cycleCount;
+            via->t1Armed = true;
+            if (via->acr & VIA_ACR_T1_PB7) {
+                via->pb7 = false;
+            }
+            cancelEvents(t1Event, via);
+            scheduleEvent(via->t1Base + via->t1Count + 1, t1Event, via);
+            clearFlags(via, VIA_INT_T1);
+            break;
+        case VIA_T1LH:
+            via->t1Latch = (via->t1Latch & 0x00FF) | (data << 8);
+            clearFlags(via, VIA_INT_T1);
+            break;
+        case VIA_T2CL:
+            via->t2LatchLow = data;
+            break;
+        case VIA_T2CH:
+            via->t2Count = (data << 8) | via->t2LatchLow;
+            via->t2Base = cycleCount;
+            via->t2Armed = true;
+            cancelEvents(t2Event, via);
+            if (!(via->acr & VIA_ACR_T2_PULSES)) {
+                scheduleEvent(via->t2Base + via->t2Count + 1, t2Event, via);
+            }
+            clearFlags(via, VIA_INT_T2);
+            break;
+        case VIA_SR:
+            via->sr = data;
+            startShift(via);
+            break;
+        case VIA_ACR:
+            writeACR(via, data);
+            break;
+        case VIA_PCR:
+            via->pcr = data;
+            break;
+        case VIA_IFR:
+            // writing a 1 clears a flag
+            clearFlags(via, data & 0x7F);
+            break;
+        case VIA_IER:
+            // bit 7 says whether the other set bits are being set or cleared
+            if (data & 0x80) {
+                via->ier |= data & 0x7F;
+            } else {
+                via->ier &= ~data;
+            }
+            updateIRQ(via);
+            break;
+    }
+}
+
+/**********************
+ * Interface routines *
+ **********************/
+
+void viaInit(W65C22 *via, MemoryMap *map, uint16_t base) {
+    via->portAPins = 0xFF;
+    via->portBPins = 0xFF;
+    via->t1Latch = 0;
+    via->t1Count = 0;
+    via->t1Base = cycleCount;
+    via->t2LatchLow = 0;
+    via->t2Count = 0;
+    via->t2Base = cycleCount;
+    via->irqAsserted = false;
+    via->irqSource = registerIRQSource6502("VIA");
+    via->context = NULL;
+    via->portWrite = NULL;
+    via->shiftOut = NULL;
+    via->shiftIn = NULL;
+    viaReset(via);
+
+    via->device.start = base;
+    via->device.end = base + 0x0F;
+    via->device.read = viaRead;
+    via->device.write = viaWrite;
+    via->device.peek = viaPeek;
+    via->device.context = via;
+    mapDevice(map, &via->device);
+}
+
+void viaReset(W65C22 *via) {
+    // /RES clears everything but the timers, their latches, and SR. The timers
+    //  carry on counting, but don't interrupt.
+    cancelEvents(t1Event, via);
+    cancelEvents(t2Event, via);
+    cancelEvents(srEvent, via);
+    via->ora = via->orb = 0;
+    via->ddra = via->ddrb = 0;
+    via->acr = via->pcr = 0;
+    via->t1Armed = false;
+    via->t2Armed = false;
+    via->pb7 = false;
+    via->shifting = false;
+    via->ier = 0;
+    via->ifr = 0;
+    updateIRQ(via);
+}
+
+void viaPulsePB6(W65C22 *via) {
+    if (!(via->acr & VIA_ACR_T2_PULSES)) {
+        return;
+    }
+    via->t2Count--;
+    if (via->t2Count == 0 && via->t2Armed) {
+        via->t2Armed = false;
+        setFlags(via, VIA_INT_T2);
+    }
+}
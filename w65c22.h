@@ -0,0 +1,133 @@
+// w65c22.h - a W65C22 VIA (Versatile Interface Adapter) device.
+// The VIA occupies 16 bytes of the address space. Its timers and shift
+//  register are driven by events on the scheduler, rather than being ticked
+//  after every instruction: writing a timer schedules an event for the cycle
+//  it runs out on, and reading a counter works out its value from cycleCount.
+//  So a running timer costs nothing until it actually does something.
+//
+// What is modelled:
+//  - Ports A and B, with their data direction registers. Input pins are set
+//     by the host in portAPins and portBPins, and portWrite, if set, is called
+//     whenever an output register or data direction register is written.
+//  - Timer 1, in one-shot and free-running mode, including PB7 output.
+//  - Timer 2, in one-shot mode, and in pulse counting mode through
+//     viaPulsePB6().
+//  - The shift register, in all of its internally clocked modes. Bytes are
+//     shifted as a whole, and the shifting finishes when all eight bits would
+//     have been clocked. Reading SR part way through gives the old byte. Bytes
+//     shifted out are passed to shiftOut, and bytes shifted in come from
+//     shiftIn. The externally clocked modes never finish.
+//  - The interrupt flag and enable registers, and the IRQ output, which drives
+//     an IRQ source of its own on the processor's IRQ line.
+// CA1, CA2, CB1 and CB2 handshaking is not modelled, although their interrupt
+//  flags can be cleared as usual.
+//
+// Timer timing follows the datasheet: a timer loaded with N reaches 0 N cycles
+//  later, and runs out (sets its interrupt flag) a cycle after that. In
+//  free-running mode, T1 then reloads from its latches, for a period of N+2.
+// Register accesses are treated as happening at the end of the instruction
+//  that makes them.
+
+#ifndef W65C22_H
+#define W65C22_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "memory-map.h"
+
+// Register offsets
+#define VIA_ORB     0x0
+#define VIA_ORA     0x1
+#define VIA_DDRB    0x2
+#define VIA_DDRA    0x3
+#define VIA_T1CL    0x4
+#define VIA_T1CH    0x5
+#define VIA_T1LL    0x6
+#define VIA_T1LH    0x7
+#define VIA_T2CL    0x8
+#define VIA_T2CH    0x9
+#define VIA_SR      0xA
+#define VIA_ACR     0xB
+#define VIA_PCR     0xC
+#define VIA_IFR     0xD
+#define VIA_IER     0xE
+#define VIA_ORA_NH  0xF     // port A without handshake
+
+// Interrupt flag and enable bits
+#define VIA_INT_CA2     0x01
+#define VIA_INT_CA1     0x02
+#define VIA_INT_SR      0x04
+#define VIA_INT_CB2     0x08
+#define VIA_INT_CB1     0x10
+#define VIA_INT_T2      0x20
+#define VIA_INT_T1      0x40
+#define VIA_INT_ANY     0x80
+
+// Auxiliary control register fields
+#define VIA_ACR_T1_PB7      0x80    // T1 drives PB7
+#define VIA_ACR_T1_FREE     0x40    // T1 free-running, rather than one-shot
+#define VIA_ACR_T2_PULSES   0x20    // T2 counts PB6 pulses
+#define VIA_ACR_SR_MASK     0x1C
+#define VIA_ACR_SR_SHIFT    2
+
+// Shift register modes, from ACR bits 4-2
+#define VIA_SR_DISABLED     0
+#define VIA_SR_IN_T2        1
+#define VIA_SR_IN_PHI2      2
+#define VIA_SR_IN_EXT       3
+#define VIA_SR_OUT_FREE     4   // out at the T2 rate, over and over, without interrupts
+#define VIA_SR_OUT_T2       5
+#define VIA_SR_OUT_PHI2     6
+#define VIA_SR_OUT_EXT      7
+
+struct W65C22 {
+    // ports
+    uint8_t ora, orb, ddra, ddrb;
+    uint8_t portAPins, portBPins;   // set by the host. Used for input bits.
+
+    // timer 1. The counter held t1Count at cycle t1Base, and counts down from
+    //  there.
+    uint16_t t1Latch;
+    uint16_t t1Count;
+    uint64_t t1Base;
+    bool t1Armed;           // interrupt when it next runs out
+    bool pb7;               // T1's PB7 output
+
+    // timer 2, counting the same way as T1 when timing
+    uint8_t t2LatchLow;
+    uint16_t t2Count;
+    uint64_t t2Base;
+    bool t2Armed;
+
+    // shift register
+    uint8_t sr;
+    bool shifting;
+
+    uint8_t acr, pcr;
+    uint8_t ifr, ier;       // bit 7 of ifr is worked out when it is read
+    bool irqAsserted;       // the IRQ output
+    uint32_t irqSource;     // this VIA's bit on the processor's IRQ line
+
+    // host hooks. Any of these may be NULL.
+    void *context;
+    void (*portWrite)(void *context, uint8_t port, uint8_t value);  // port is VIA_ORA or VIA_ORB
+    void (*shiftOut)(void *context, uint8_t data);
+    uint8_t (*shiftIn)(void *context);  // 0xFF is shifted in if this isn't set
+
+    MappedDevice device;
+};
+
+// Resets the VIA, as its /RES input would, puts its registers at base, and
+//  adds it to the map. The host hooks and pins are cleared, so set them after
+//  calling this.
+void viaInit(W65C22 *via, MemoryMap *map, uint16_t base);
+
+// Resets the VIA's registers and cancels its timers, without touching the map.
+void viaReset(W65C22 *via);
+
+// Counts one pulse on PB6, for T2 in pulse counting mode.
+void viaPulsePB6(W65C22 *via);
+
+#endif // ifndef W65C22_H
@@ -0,0 +1,37 @@
+// wakeup.cpp - lets the run loop sleep while the emulated processor is idle.
+
+#include "wakeup.h"
+
+void wakeupInit(Wakeup *wakeup) {
+    pthread_mutex_init(&wakeup->lock, NULL);
+    pthread_cond_init(&wakeup->signalled, NULL);
+    wakeup->woken = false;
+    wakeup->sleeping = false;
+}
+
+void wakeupSignal(Wakeup *wakeup) {
+    // If woken was already set, whoever set it has already taken care of
+    //  waking the waiter. Both this and wakeupWait() use sequentially
+    //  consistent operations on woken and sleeping, so at least one of them
+    //  sees what the other did.
+    if (__atomic_exchange_n(&wakeup->woken, true, __ATOMIC_SEQ_CST)) {
+        return;
+    }
+    if (__atomic_load_n(&wakeup->sleeping, __ATOMIC_SEQ_CST)) {
+        // taking the lock makes sure the waiter is either in
+        //  pthread_cond_wait(), or hasn't yet looked at woken
+        pthread_mutex_lock(&wakeup->lock);
+        pthread_cond_signal(&wakeup->signalled);
+        pthread_mutex_unlock(&wakeup->lock);
+    }
+}
+
+void wakeupWait(Wakeup *wakeup) {
+    pthread_mutex_lock(&wakeup->lock);
+    __atomic_store_n(&wakeup->sleeping, true, __ATOMIC_SEQ_CST);
+    while (!__atomic_exchange_n(&wakeup->woken, false, __ATOMIC_SEQ_CST)) {
+        pthread_cond_wait(&wakeup->signalled, &wakeup->lock);
+    }
+    __atomic_store_n(&wakeup->sleeping, false, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&wakeup->lock);
+}
@@ -0,0 +1,31 @@
+// wakeup.h - lets the run loop sleep while the emulated processor is idle in
+//  WAI or STP, until something happens that it needs to look at.
+// Anything that could end the idle, such as an interrupt being raised or a key
+//  being pressed, calls wakeupSignal(). It can be called from any thread.
+// A signal isn't lost if it comes before the run loop gets round to waiting;
+//  the next wakeupWait() just returns straight away.
+// Signalling is lock-free unless the run loop is actually asleep, so device
+//  threads that raise interrupts at a high rate don't contend on the lock
+//  while the processor is busy.
+
+#ifndef WAKEUP_H
+#define WAKEUP_H
+
+#include <pthread.h>
+
+struct Wakeup {
+    pthread_mutex_t lock;
+    pthread_cond_t signalled;
+    bool woken;             // accessed atomically
+    bool sleeping;          // accessed atomically. Only set while lock is held.
+};
+
+void wakeupInit(Wakeup *wakeup);
+
+// Wakes the thread in wakeupWait(), or makes the next wait return at once.
+void wakeupSignal(Wakeup *wakeup);
+
+// Blocks until wakeupSignal() has been called since the last wait returned.
+void wakeupWait(Wakeup *wakeup);
+
+#endif // ifndef WAKEUP_H